@@ -0,0 +1,165 @@
+/*
+ * herramientas/decodificar_traza.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa que se ejecuta en el anfitrin y convierte un volcado de la
+ * traza del ncleo (lneas "@T tiempo tipo id arg" que escribe
+ * usuario/volcar_traza) en una cronologa legible, seguida de un
+ * resumen por proceso. Ignora el resto de lneas de la entrada, por lo
+ * que se le puede pasar directamente la salida del sistema. Con -r
+ * muestra tambin las interrupciones de reloj.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "llamsis.h"
+#include "traza.h"
+
+#define MAX_PROCS 4096		/* procesos distintos en el resumen */
+
+static const char *nombres_llamsis[NSERVICIOS]=NOMBRES_LLAMSIS;
+
+/* Datos de cada proceso para el resumen, por orden de aparicion */
+struct proceso {
+	int id;
+	int cambios;		/* veces que ha pasado a ejecutar */
+	int llamadas;
+	int despertares;
+	int llamada_en_curso;	/* -1 si no esta en una llamada */
+	long long inicio_llamada;
+};
+
+static struct proceso procs[MAX_PROCS];
+static int num_procs=0;
+
+static const char * nombre_llamsis(int n){
+	static char desconocida[32];
+
+	if ((n>=0) && (n<NSERVICIOS) && nombres_llamsis[n])
+		return nombres_llamsis[n];
+	sprintf(desconocida, "llamada %d", n);
+	return desconocida;
+}
+
+/*
+ * Datos de un proceso, dados de alta la primera vez que aparece. Los
+ * identificadores llevan la generacion de la entrada de la tabla de
+ * procesos, asi que no sirven de indice.
+ */
+static struct proceso * proceso(int id){
+	int i;
+
+	if (id<0)
+		return NULL;
+	for (i=0; i<num_procs; i++)
+		if (procs[i].id==id)
+			return &procs[i];
+	if (num_procs==MAX_PROCS)
+		return NULL;
+	procs[num_procs].id=id;
+	procs[num_procs].llamada_en_curso=-1;
+	return &procs[num_procs++];
+}
+
+static void imprimir_evento(double ms, struct evento_traza *ev, int reloj){
+	struct proceso *p=proceso(ev->id);
+
+	switch (ev->tipo) {
+	case EV_CAMBIO:
+		if (proceso(ev->arg))
+			proceso(ev->arg)->cambios++;
+		printf("%12.3f  cambio de contexto: %d -> %d\n", ms,
+			ev->id, ev->arg);
+		break;
+	case EV_DESPERTAR:
+		if (p)
+			p->despertares++;
+		printf("%12.3f  despierta %d\n", ms, ev->id);
+		break;
+	case EV_LLAMSIS:
+		if (p) {
+			p->llamadas++;
+			p->llamada_en_curso=ev->arg;
+			p->inicio_llamada=ev->tiempo;
+		}
+		printf("%12.3f  %d entra en %s\n", ms, ev->id,
+			nombre_llamsis(ev->arg));
+		break;
+	case EV_FIN_LLAMSIS:
+		if (p && (p->llamada_en_curso>=0)) {
+			printf("%12.3f  %d sale de %s = %d (%.3f ms)\n", ms,
+				ev->id, nombre_llamsis(p->llamada_en_curso),
+				ev->arg, (ev->tiempo-p->inicio_llamada)/1e6);
+			p->llamada_en_curso=-1;
+		}
+		else
+			printf("%12.3f  %d sale de una llamada = %d\n", ms,
+				ev->id, ev->arg);
+		break;
+	case EV_INT_RELOJ:
+		if (reloj)
+			printf("%12.3f  reloj: tick %d (en %d)\n", ms,
+				ev->arg, ev->id);
+		break;
+	case EV_INT_TERMINAL:
+		printf("%12.3f  terminal: '%c' (en %d)\n", ms, ev->arg,
+			ev->id);
+		break;
+	case EV_INT_SW:
+		printf("%12.3f  int. SW en %d\n", ms, ev->id);
+		break;
+	case EV_PERDIDO:
+		printf("%12.3f  terminal: '%c' descartado, buffer lleno\n", ms,
+			ev->arg);
+		break;
+	default:
+		printf("%12.3f  evento desconocido %d\n", ms, (int)ev->tipo);
+	}
+}
+
+int main(int argc, char *argv[]){
+	char linea[512], *p;
+	struct evento_traza ev;
+	long long inicio=0, tiempo;
+	int tipo, id, arg, i, reloj=0, total=0;
+	int por_tipo[NUM_EVENTOS];
+
+	if ((argc==2) && (strcmp(argv[1], "-r")==0))
+		reloj=1;
+	else if (argc!=1) {
+		fprintf(stderr, "Uso: %s [-r] < volcado\n", argv[0]);
+		return 1;
+	}
+
+	memset(por_tipo, 0, sizeof(por_tipo));
+	while (fgets(linea, sizeof(linea), stdin)) {
+		if (((p=strstr(linea, "@T "))==NULL) ||
+		    (sscanf(p+3, "%lld %d %d %d", &tiempo, &tipo, &id, &arg)!=4))
+			continue;
+		if (total++==0)
+			inicio=tiempo;
+		ev.tiempo=tiempo;
+		ev.tipo=tipo;
+		ev.id=id;
+		ev.arg=arg;
+		if ((tipo>=0) && (tipo<NUM_EVENTOS))
+			por_tipo[tipo]++;
+		imprimir_evento((tiempo-inicio)/1e6, &ev, reloj);
+	}
+
+	printf("\n%d eventos: %d cambios, %d despertares, %d llamadas, "
+		"%d int. reloj, %d int. terminal, %d int. SW, %d descartes\n",
+		total, por_tipo[EV_CAMBIO], por_tipo[EV_DESPERTAR],
+		por_tipo[EV_LLAMSIS], por_tipo[EV_INT_RELOJ],
+		por_tipo[EV_INT_TERMINAL], por_tipo[EV_INT_SW],
+		por_tipo[EV_PERDIDO]);
+	for (i=0; i<num_procs; i++)
+		printf("proceso %d: %d veces en ejecucion, %d llamadas, "
+			"%d despertares\n", procs[i].id, procs[i].cambios,
+			procs[i].llamadas, procs[i].despertares);
+	return 0;
+}
@@ -0,0 +1,645 @@
+/*
+ *  minikernel/HAL.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ *  Fernando Prez Costoya
+ *
+ */
+
+/*
+ *
+ * Implementacin en fuente del mdulo HAL, alternativa a los binarios
+ * HAL.o_32 y HAL.o_64 (se usa con "make HAL=fuente").
+ *
+ * El "hardware" se simula con un proceso UNIX, en el que cada UCP es un
+ * hilo (solo la 0 si no se llama a arrancar_ucps):
+ *
+ *	- Los contextos son ucontext_t y el cambio se hace con swapcontext.
+ *	  Un contexto salvado en una UCP se puede restaurar en otra.
+ *	- Cada vector de interrupcin corresponde a una seal, dirigida
+ *	  al hilo de la UCP que la debe tratar:
+ *		EXC_ARITM	SIGFPE
+ *		EXC_MEM		SIGSEGV, SIGBUS, SIGILL
+ *		INT_RELOJ	SIGALRM (un temporizador por UCP)
+ *		INT_TERMINAL	SIGIO (entrada asncrona del terminal, a la
+ *				UCP 0)
+ *		LLAM_SIS	SIGUSR1 (la genera trap en la biblioteca)
+ *		INT_SW		SIGUSR2
+ *		INT_IPI		SIGURG
+ *	- El nivel de interrupcin es la mscara de seales del hilo: el
+ *	  nivel N bloquea las seales de los vectores de nivel menor o
+ *	  igual que N. La interrupcin entre UCP es de nivel 3.
+ *	- Para saber si una interrupcin llega desde modo usuario, cada
+ *	  manejador bloquea adems una seal "marca" que no se usa para
+ *	  otra cosa; si hay ms de un manejador activo se vena del ncleo.
+ *
+ * Los registros del procesador son un vector de cada hilo. La biblioteca
+ * de usuario accede a ellos a travs de su variable reglib o, si la
+ * tiene (misc.c), de la funcin a la que apunta reglib_ucp, que es la
+ * nica forma de llegar a los de cada UCP. cambio_contexto los salva y
+ * restaura en el contexto de cada proceso.
+ *
+ */
+#define _GNU_SOURCE		/* F_SETOWN_EX */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <dlfcn.h>
+#include <termios.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+#include "HAL.h"
+#include "const.h"
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/* Marcas de manejador activo (ver viene_de_modo_usuario) */
+#define MARCA_RELOJ SIGPROF
+#define MARCA_TERMINAL SIGXCPU
+#define MARCA_SW SIGXFSZ	/* llamadas al sistema e int. SW */
+#define MARCA_IPI SIGVTALRM
+
+/* directorio del ejecutable del S.O.; lo fija el programa de arranque */
+char *dir_base;
+
+static void (*tabla_vectores[NVECTORES])();
+static int nprocs;	/* imgenes creadas y no liberadas */
+
+/* Estado de cada UCP */
+static __thread long registros[NREGS];
+static __thread int num_ucp;		/* nmero de la UCP del hilo */
+static __thread timer_t reloj;		/* temporizador de la UCP */
+
+static long periodo_reloj;	/* microsegundos por tick (0 sin reloj) */
+static int num_ucps=1;
+static pid_t *hilos_ucps;	/* hilo de cada UCP */
+static void (*inicio_ucps)();	/* funcin que ejecutan las UCP 1.. */
+static void (*arranque_procesos)(); /* la ejecuta cada proceso nuevo */
+static volatile int ucps_listas; /* UCP 1.. que ya han arrancado */
+
+/*
+ *
+ * Funciones auxiliares
+ *
+ */
+
+/*
+ * Mscara de seales correspondiente a un nivel de interrupcin.
+ */
+static void mascara_nivel(int nivel, sigset_t *mascara){
+	switch (nivel) {
+	case NIVEL_3:
+		sigaddset(mascara, SIGALRM);
+		sigaddset(mascara, SIGURG);
+	case NIVEL_2:
+		sigaddset(mascara, SIGIO);
+	case NIVEL_1:
+		sigaddset(mascara, SIGUSR1);
+		sigaddset(mascara, SIGUSR2);
+	}
+}
+
+/*
+ * Devuelve el terminal a modo cannico con eco, tal como estaba antes
+ * de iniciar_cont_teclado.
+ */
+static void restaurar_terminal(){
+	struct termios t;
+
+	if (tcgetattr(0, &t)<0)
+		return;
+	t.c_lflag |= (ICANON|ECHO);
+	tcsetattr(0, TCSANOW, &t);
+}
+
+static pid_t hilo_actual(){
+	return syscall(SYS_gettid);
+}
+
+/*
+ * Registros de la UCP que invoca la funcin, para la biblioteca de
+ * usuario (reglib_ucp).
+ */
+static long *registros_ucp(){
+	return registros;
+}
+
+/*
+ * Crea el temporizador de la UCP que lo invoca, que enva SIGALRM a su
+ * hilo una vez por tick.
+ */
+static void iniciar_reloj_ucp(){
+	struct sigevent ev;
+	struct itimerspec t;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.sigev_notify=SIGEV_THREAD_ID;
+	ev.sigev_signo=SIGALRM;
+	ev.sigev_notify_thread_id=hilo_actual();
+	if (timer_create(CLOCK_MONOTONIC, &ev, &reloj)<0) {
+		perror("timer_create");
+		exit(1);
+	}
+	t.it_value.tv_sec = periodo_reloj / 1000000;
+	t.it_value.tv_nsec = periodo_reloj % 1000000 * 1000;
+	t.it_interval = t.it_value;
+	timer_settime(reloj, 0, &t, NULL);
+}
+
+/*
+ * Hilo de las UCP distintas de la 0: arranca con las interrupciones
+ * inhibidas (hereda la mscara de arrancar_ucps).
+ */
+static void *hilo_ucp(void *arg){
+	num_ucp=(long)arg;
+	hilos_ucps[num_ucp]=hilo_actual();
+	if (periodo_reloj)
+		iniciar_reloj_ucp();
+	__sync_fetch_and_add(&ucps_listas, 1);
+	inicio_ucps();
+	return NULL;
+}
+
+static void salvar_registros(long *regs){
+	memcpy(regs, registros, sizeof(registros));
+}
+
+static void restaurar_registros(long *regs){
+	memcpy(registros, regs, sizeof(registros));
+}
+
+/*
+ *
+ * Preludios: manejadores de seal que invocan la rutina del vector
+ *
+ */
+
+static void man_exc_preludio(int senal){
+	if (senal==SIGFPE)
+		tabla_vectores[EXC_ARITM]();
+	else
+		tabla_vectores[EXC_MEM]();
+}
+
+static void man_int_preludio(int senal){
+	fd_set lectura;
+	struct timeval espera = {0, 0};
+	int nivel, hay_dato;
+
+	if (senal==SIGALRM) {
+		tabla_vectores[INT_RELOJ]();
+		return;
+	}
+	if (senal==SIGURG) {
+		tabla_vectores[INT_IPI]();
+		return;
+	}
+	if (senal!=SIGIO)
+		panico("INTERRUPCION INESPERADA");
+
+	/* SIGIO tambin llega sin datos (p.ej. al cerrar el terminal) */
+	FD_ZERO(&lectura);
+	FD_SET(0, &lectura);
+	nivel=fijar_nivel_int(NIVEL_3);
+	hay_dato=(select(1, &lectura, NULL, NULL, &espera)>0);
+	fijar_nivel_int(nivel);
+	if (hay_dato)
+		tabla_vectores[INT_TERMINAL]();
+}
+
+static void llam_sis_preludio(int senal){
+	tabla_vectores[LLAM_SIS]();
+}
+
+static void int_sw_preludio(int senal){
+	tabla_vectores[INT_SW]();
+}
+
+/*
+ * Primera funcin que ejecuta un proceso: desbloquea todas las seales
+ * (modo usuario) y llama a start de la biblioteca con la direccin de
+ * main. makecontext slo pasa argumentos int, por lo que los punteros
+ * llegan partidos en dos mitades.
+ */
+static void lanzadera(unsigned int start_bajo, unsigned int start_alto,
+			unsigned int pc_bajo, unsigned int pc_alto){
+	void (*start)(void *);
+	void *pc;
+	sigset_t vacia;
+
+	start=(void (*)(void *))
+		(((unsigned long)start_alto<<16<<16) | start_bajo);
+	pc=(void *)(((unsigned long)pc_alto<<16<<16) | pc_bajo);
+	if (arranque_procesos)
+		arranque_procesos();
+	sigemptyset(&vacia);
+	sigprocmask(SIG_SETMASK, &vacia, NULL);
+	start(pc);
+}
+
+/*
+ *
+ * Operaciones relacionadas con los dispositivos y las interrupciones.
+ *
+ */
+
+/*
+ * Devuelve la hora actual en milisegundos.
+ */
+unsigned long long int leer_reloj_CMOS(){
+	struct timeval t;
+
+	gettimeofday(&t, NULL);
+	return (unsigned long long int)t.tv_sec*1000 + t.tv_usec/1000;
+}
+
+/*
+ * Arranca el reloj de la UCP 0; las dems lo arrancan al crearse.
+ */
+void iniciar_cont_reloj(int ticks_por_seg){
+	periodo_reloj = 1000000/ticks_por_seg;
+	iniciar_reloj_ucp();
+}
+
+/*
+ * Los dos siguientes actan sobre el reloj de la UCP que los invoca.
+ */
+void programar_reloj(long usegs){
+	struct itimerspec t;
+
+	if (usegs < 1)
+		usegs = 1;		/* con 0 se parara el temporizador */
+	timer_gettime(reloj, &t);
+	t.it_value.tv_sec = usegs / 1000000;
+	t.it_value.tv_nsec = usegs % 1000000 * 1000;
+	timer_settime(reloj, 0, &t, NULL);
+}
+
+long consultar_reloj(){
+	struct itimerspec t;
+
+	timer_gettime(reloj, &t);
+	return t.it_value.tv_sec * 1000000 + t.it_value.tv_nsec / 1000;
+}
+
+/*
+ * Pone el terminal en modo no cannico sin eco y hace que cada
+ * carcter tecleado genere SIGIO en la UCP que lo invoca (la 0).
+ */
+void iniciar_cont_teclado(){
+	struct termios t;
+	struct f_owner_ex propietario;
+	int flags;
+
+	if (tcgetattr(0, &t)<0) {
+		perror("Error obteniendo atributos del terminal");
+		exit(1);
+	}
+	t.c_lflag &= ~(ICANON|ECHO);
+	t.c_cc[VMIN]=1;
+	t.c_cc[VTIME]=0;
+	tcsetattr(0, TCSANOW, &t);
+
+	propietario.type=F_OWNER_TID;
+	propietario.pid=hilo_actual();
+	if (fcntl(0, F_SETOWN_EX, &propietario)<0) {
+		perror("fcntl F_SETOWN_EX");
+		exit(1);
+	}
+	if ((flags=fcntl(0, F_GETFL))<0) {
+		perror("fcntl F_GETFL");
+		exit(1);
+	}
+	if (fcntl(0, F_SETFL, flags|O_ASYNC)<0) {
+		perror("fcntl F_SETFL");
+		exit(1);
+	}
+}
+
+/*
+ * Asocia cada seal con su preludio. La mscara de cada manejador
+ * corresponde al nivel de su vector ms la marca del manejador.
+ */
+void iniciar_cont_int(){
+	struct sigaction act;
+
+	memset(&act, 0, sizeof(act));
+
+	act.sa_handler=int_sw_preludio;
+	sigemptyset(&act.sa_mask);
+	sigaddset(&act.sa_mask, MARCA_SW);
+	sigaction(SIGUSR2, &act, NULL);
+
+	act.sa_handler=llam_sis_preludio;
+	sigemptyset(&act.sa_mask);
+	sigaddset(&act.sa_mask, SIGUSR2);
+	sigaddset(&act.sa_mask, MARCA_SW);
+	sigaction(SIGUSR1, &act, NULL);
+
+	act.sa_handler=man_int_preludio;
+	act.sa_flags=SA_RESTART;
+	sigemptyset(&act.sa_mask);
+	mascara_nivel(NIVEL_2, &act.sa_mask);
+	sigaddset(&act.sa_mask, MARCA_RELOJ);
+	sigaction(SIGALRM, &act, NULL);
+
+	sigemptyset(&act.sa_mask);
+	mascara_nivel(NIVEL_1, &act.sa_mask);
+	sigaddset(&act.sa_mask, MARCA_TERMINAL);
+	sigaction(SIGIO, &act, NULL);
+
+	sigemptyset(&act.sa_mask);
+	mascara_nivel(NIVEL_2, &act.sa_mask);
+	sigaddset(&act.sa_mask, MARCA_IPI);
+	sigaction(SIGURG, &act, NULL);
+
+	act.sa_handler=man_exc_preludio;
+	act.sa_flags=0;
+	sigemptyset(&act.sa_mask);
+	sigaddset(&act.sa_mask, SIGUSR2);
+	sigaction(SIGILL, &act, NULL);
+	sigaction(SIGBUS, &act, NULL);
+	sigaction(SIGFPE, &act, NULL);
+	sigaction(SIGSEGV, &act, NULL);
+}
+
+void instal_man_int(int nvector, void (*manej)()){
+	if ((nvector<0) || (nvector>=NVECTORES))
+		panico("usando un vector no existente");
+	tabla_vectores[nvector]=manej;
+}
+
+/*
+ * Fija el nivel conservando las marcas de los manejadores activos.
+ * Devuelve el nivel previo.
+ */
+int fijar_nivel_int(int nivel){
+	sigset_t actual, nueva, previa;
+
+	sigprocmask(SIG_SETMASK, NULL, &actual);
+	sigemptyset(&nueva);
+	if (sigismember(&actual, MARCA_RELOJ))
+		sigaddset(&nueva, MARCA_RELOJ);
+	if (sigismember(&actual, MARCA_TERMINAL))
+		sigaddset(&nueva, MARCA_TERMINAL);
+	if (sigismember(&actual, MARCA_SW))
+		sigaddset(&nueva, MARCA_SW);
+	if (sigismember(&actual, MARCA_IPI))
+		sigaddset(&nueva, MARCA_IPI);
+	mascara_nivel(nivel, &nueva);
+
+	if (sigprocmask(SIG_SETMASK, &nueva, &previa)!=0)
+		perror("sigprocmask");
+
+	if (sigismember(&previa, SIGALRM))
+		return NIVEL_3;
+	if (sigismember(&previa, SIGIO))
+		return NIVEL_2;
+	return NIVEL_1;
+}
+
+/*
+ * Cuenta los manejadores activos: el que invoca esta funcin y, si se
+ * vena del ncleo, al menos el interrumpido.
+ */
+int viene_de_modo_usuario(){
+	static const int marcas[]={MARCA_RELOJ, MARCA_TERMINAL, MARCA_SW,
+				MARCA_IPI, SIGILL, SIGBUS, SIGFPE, SIGSEGV};
+	sigset_t actual;
+	int i, activos=0;
+
+	sigprocmask(SIG_SETMASK, NULL, &actual);
+	for (i=0; i<sizeof(marcas)/sizeof(marcas[0]); i++)
+		if (sigismember(&actual, marcas[i]))
+			activos++;
+	return activos<=1;
+}
+
+void activar_int_SW(){
+	syscall(SYS_tgkill, getpid(), hilo_actual(), SIGUSR2);
+}
+
+/*
+ *
+ * Operaciones del multiprocesador.
+ *
+ */
+
+/*
+ * Crea un hilo por cada UCP adicional y espera a que todos tengan su
+ * reloj. Las UCP nuevas heredan la mscara con el nivel 3.
+ */
+int arrancar_ucps(int n, void (*inicio)(), void (*arranque)()){
+	pthread_t hilo;
+	sigset_t nivel3, previa;
+	long i;
+
+	if (n<=1)
+		return 0;
+	if ((hilos_ucps=calloc(n, sizeof(pid_t)))==NULL)
+		return -1;
+	hilos_ucps[0]=hilo_actual();
+	inicio_ucps=inicio;
+	arranque_procesos=arranque;
+	num_ucps=n;
+
+	sigemptyset(&nivel3);
+	mascara_nivel(NIVEL_3, &nivel3);
+	pthread_sigmask(SIG_BLOCK, &nivel3, &previa);
+	for (i=1; i<n; i++)
+		if (pthread_create(&hilo, NULL, hilo_ucp, (void *)i)!=0)
+			panico("no se puede crear el hilo de una UCP");
+	pthread_sigmask(SIG_SETMASK, &previa, NULL);
+
+	while (ucps_listas < n-1)
+		sched_yield();
+	return 0;
+}
+
+int ucp_actual(){
+	return num_ucp;
+}
+
+void activar_IPI(int ucp){
+	if ((ucp<0) || (ucp>=num_ucps) || (hilos_ucps[ucp]==0))
+		return;
+	syscall(SYS_tgkill, getpid(), hilos_ucps[ucp], SIGURG);
+}
+
+/*
+ * Los hilos de las UCP pueden compartir un mismo procesador real: el que
+ * espera lo cede para que avance el que tiene lo que se espera.
+ */
+void pausa_ucp(){
+	sched_yield();
+}
+
+/*
+ *
+ * Operacin de salvaguarda y recuperacin de contexto hardware del proceso.
+ *
+ */
+void cambio_contexto(contexto_t *contexto_a_salvar,
+			contexto_t *contexto_a_restaurar){
+	if (contexto_a_salvar==NULL) {
+		setcontext(&contexto_a_restaurar->ctxt);
+		return;
+	}
+	if (contexto_a_salvar==contexto_a_restaurar)
+		return;
+	salvar_registros(contexto_a_salvar->registros);
+	swapcontext(&contexto_a_salvar->ctxt, &contexto_a_restaurar->ctxt);
+	restaurar_registros(contexto_a_salvar->registros);
+}
+
+/*
+ *
+ * Operaciones relacionadas con mapa de memoria del proceso y pila
+ *
+ */
+
+/*
+ * Carga el programa de ../usuario (relativo al S.O.) como biblioteca
+ * dinmica y hace que su biblioteca de sistema use los registros.
+ */
+void * crear_imagen(char *prog, void **dir_ini){
+	char ruta[PATH_MAX];
+	void *imagen;
+	long **reglib;
+	long *(**reglib_ucp)();
+
+	snprintf(ruta, sizeof(ruta), "%s../usuario/%s", dir_base, prog);
+	if ((imagen=dlopen(ruta, RTLD_LAZY))==NULL)
+		return NULL;
+	*dir_ini=dlsym(imagen, "main");
+	reglib=dlsym(imagen, "reglib");
+	if ((*dir_ini==NULL) || (reglib==NULL)) {
+		dlclose(imagen);
+		return NULL;
+	}
+	/* con varias UCP la biblioteca tiene que usar los de cada una */
+	reglib_ucp=dlsym(imagen, "reglib_ucp");
+	if ((reglib_ucp==NULL) && (num_ucps>1))
+		panico("programa enlazado con el misc.o binario: no admite varias UCP");
+	*reglib=registros;
+	if (reglib_ucp)
+		*reglib_ucp=registros_ucp;
+	nprocs++;
+	return imagen;
+}
+
+void * crear_pila(int tam){
+	return malloc(tam);
+}
+
+void fijar_contexto_ini(void *mem, void *p_pila, int tam_pila,
+			void * pc_inicial, contexto_t *contexto_ini){
+	unsigned long start, pc=(unsigned long)pc_inicial;
+	ucontext_t *c=&contexto_ini->ctxt;
+
+	if ((start=(unsigned long)dlsym(mem, "start"))==0)
+		return;
+
+	getcontext(c);
+	c->uc_link=NULL;
+	c->uc_stack.ss_sp=p_pila;
+	c->uc_stack.ss_size=tam_pila;
+	/* arranca al nivel 3: la lanzadera pasa a modo usuario */
+	sigemptyset(&c->uc_sigmask);
+	mascara_nivel(NIVEL_3, &c->uc_sigmask);
+	makecontext(c, (void (*)())lanzadera, 4,
+		(unsigned int)start, (unsigned int)(start>>16>>16),
+		(unsigned int)pc, (unsigned int)(pc>>16>>16));
+}
+
+/*
+ * Al liberar la ltima imagen el sistema se para.
+ */
+void liberar_imagen(void *mem){
+	dlclose(mem);
+	if (--nprocs==0) {
+		restaurar_terminal();
+		exit(0);
+	}
+}
+
+void liberar_pila(void *pila){
+	free(pila);
+}
+
+/*
+ *
+ * Operaciones miscelneas
+ *
+ */
+
+long leer_registro(int nreg){
+	if ((nreg<0) || (nreg>=NREGS))
+		return 0;
+	return registros[nreg];
+}
+
+int escribir_registro(int nreg, long valor){
+	if ((nreg<0) || (nreg>=NREGS))
+		return -1;
+	registros[nreg]=valor;
+	return 0;
+}
+
+/*
+ * El nico puerto existente es el del terminal.
+ */
+char leer_puerto(int dir_puerto){
+	char car=0;
+
+	if (dir_puerto==DIR_TERMINAL)
+		read(0, &car, 1);
+	return car;
+}
+
+void halt(){
+	pause();
+}
+
+void panico(char *mens){
+	fijar_nivel_int(NIVEL_3);
+	write(2, mens, strlen(mens));
+	write(2, "\n", 1);
+	restaurar_terminal();
+	exit(1);
+}
+
+void escribir_ker(char *buffer, unsigned int longi){
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	write(1, buffer, longi);
+	fijar_nivel_int(nivel);
+}
+
+int printk(const char *formato, ...){
+	char buf[1024];
+	va_list ap;
+	int n;
+
+	va_start(ap, formato);
+	n=vsnprintf(buf, sizeof(buf), formato, ap);
+	va_end(ap);
+	if (n>=(int)sizeof(buf))
+		n=sizeof(buf)-1;
+	if (n>0)
+		escribir_ker(buf, n);
+	return n;
+}
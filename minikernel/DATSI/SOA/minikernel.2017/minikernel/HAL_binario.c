@@ -0,0 +1,51 @@
+/*
+ *  minikernel/HAL_binario.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ *
+ * Primitivas de HAL.h posteriores a los binarios HAL.o_32 y HAL.o_64, que
+ * se enlazan junto a ellos. El HAL binario genera la interrupcin de
+ * reloj con el temporizador ITIMER_REAL, que programa en
+ * iniciar_cont_reloj (con "make HAL=fuente" estn en HAL.c). Adems
+ * solo simula una UCP.
+ *
+ */
+#include <stddef.h>
+#include <sys/time.h>
+#include "HAL.h"
+
+void programar_reloj(long usegs){
+	struct itimerval t;
+
+	if (usegs < 1)
+		usegs = 1;		/* con 0 se parara el temporizador */
+	getitimer(ITIMER_REAL, &t);	/* conserva el periodo del tick */
+	t.it_value.tv_sec = usegs / 1000000;
+	t.it_value.tv_usec = usegs % 1000000;
+	setitimer(ITIMER_REAL, &t, NULL);
+}
+
+long consultar_reloj(){
+	struct itimerval t;
+
+	getitimer(ITIMER_REAL, &t);
+	return t.it_value.tv_sec * 1000000 + t.it_value.tv_usec;
+}
+
+int arrancar_ucps(int n, void (*inicio)(), void (*arranque)()){
+	return (n > 1) ? -1 : 0;
+}
+
+int ucp_actual(){
+	return 0;
+}
+
+void activar_IPI(int ucp){
+}
+
+void pausa_ucp(){
+}
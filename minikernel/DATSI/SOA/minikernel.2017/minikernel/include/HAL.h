@@ -76,6 +76,12 @@ unsigned long long int leer_reloj_CMOS(); /* obtiene hora del rejoj CMOS */
 
 void iniciar_cont_reloj(int ticks_por_seg); /* iniciar controlador de reloj */
 
+/* la siguiente interrupcin de reloj llega dentro de usegs microsegundos
+   y las dems, de nuevo, una por tick */
+void programar_reloj(long usegs);
+
+long consultar_reloj(); /* microsegundos hasta la siguiente int. de reloj */
+
 void iniciar_cont_teclado(); /* iniciar controlador de teclado */
 
 void iniciar_cont_int();  /* iniciar controlador de interrupciones. */
@@ -90,6 +96,25 @@ int viene_de_modo_usuario(); /* Devuelve verdadero si el modo previo de
 
 void activar_int_SW(); /* activa la interrupcin SW */
 
+/*
+ *
+ * Operaciones del multiprocesador. Cada UCP tiene sus propios registros,
+ * nivel de interrupcin y reloj; la interrupcin de terminal llega
+ * siempre a la UCP 0, que es la que arranca el sistema.
+ *
+ */
+
+/* arranca las UCP 1 a n-1, que ejecutan inicio() al nivel 3; cada
+   proceso nuevo ejecuta arranque(), tambin al nivel 3, antes de pasar a
+   modo usuario. Devuelve -1 si no es posible */
+int arrancar_ucps(int n, void (*inicio)(), void (*arranque)());
+
+int ucp_actual(); /* nmero de la UCP que la invoca */
+
+void activar_IPI(int ucp); /* activa la interrupcin entre UCP en otra UCP */
+
+void pausa_ucp(); /* pausa dentro de una espera activa */
+
 /*
  *
  * Operacin de salvaguarda y recuperacin de contexto hardware del proceso.
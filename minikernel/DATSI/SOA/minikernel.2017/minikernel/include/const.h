@@ -26,6 +26,15 @@
 
 #define TAM_PILA 32768
 
+/*
+ * Area de usuario: los primeros bytes de la pila de cada proceso, que no
+ * forman parte de la pila propiamente dicha. La pila se alinea a su
+ * tamao para que la biblioteca de usuario encuentre el area a partir
+ * de la direccion de cualquier variable local. El nucleo la pone a cero
+ * al crear el proceso y no la vuelve a tocar.
+ */
+#define TAM_AREA_USUARIO 1024
+
 
 /*
  * Posibles estados del proceso
@@ -51,7 +60,7 @@
  */
 
 /* Numero de vectores de interrupcion disponibles */
-#define NVECTORES 6
+#define NVECTORES 7
 
 /* Numeros de vector */
 #define EXC_ARITM 0     /* excepcion aritmetica */
@@ -60,6 +69,7 @@
 #define INT_TERMINAL 3  /* interrupcion de entrada de terminal */
 #define LLAM_SIS 4      /* vector usado para llamadas */
 #define INT_SW 5	/* vector usado para interrupciones software */
+#define INT_IPI 6	/* interrupcion entre UCP (solo con varias UCP) */
 
 /* frecuencia de reloj requerida (ticks/segundo) */
 #define TICK 100
@@ -72,9 +82,13 @@
 #define NUM_MUT_PROC 4 /* numero maximo de mutex que puede tener
 			  abiertos un proceso */
 #define MAX_NOM_MUT 8 /* longitud maxima de un nombre de mutex */
+#define ESPERAS_MUTEX 0x80000000 /* bit de la palabra de un mutex que indica
+				    que hay procesos esperando */
 
 /* constante usada en implementacion de manejador de terminal */
-#define TAM_BUF_TERM 8 /* tamao del buffer del terminal */
+#ifndef TAM_BUF_TERM
+#define TAM_BUF_TERM 8 /* tamao del buffer del terminal (potencia de 2) */
+#endif
 
 /* direccin de puerto de E/S del terminal */
 #define DIR_TERMINAL 1
@@ -21,24 +21,177 @@
 #include "const.h"
 #include "HAL.h"
 #include "llamsis.h"
+#include "traza.h"
+#include "latencias.h"
 
 
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
 
+#define TAM_HASH_MUT 32		/* cubetas de la tabla hash de nombres de
+				   mutex (potencia de 2) */
 
+/*
+ * Constantes de la planificacion multinivel con realimentacion
+ */
+#define NUM_COLAS_LISTOS 4	/* niveles de prioridad de la cola de listos */
+#define PERIODO_ENVEJECIMIENTO 200 /* ticks entre dos envejecimientos */
 
+/* rodaja asignada en cada nivel: se duplica al bajar de nivel */
+#define RODAJA_NIVEL(n) (TICKS_POR_RODAJA << (n))
 
 /*
- * Definimos un mutex compuesto por su nombre, tipo , arrays procesos abiertos y bloqueados.
+ * Clases de planificacion: multinivel con realimentacion, reparto
+ * equitativo ponderado por el valor nice de cada proceso, FIFO sin
+ * expulsion y round robin. Se elige al arrancar con la variable de
+ * entorno PLANIFICACION (mlfq, cfs, fifo o rr); si no esta definida se
+ * usa la fijada al compilar, p.ej. -DPLANIFICACION=PLAN_RR.
+ */
+#define PLAN_MLFQ 0
+#define PLAN_CFS 1
+#define PLAN_FIFO 2
+#define PLAN_RR 3
+#define NUM_PLANIFICACIONES 4
 
+#ifndef PLANIFICACION
+#define PLANIFICACION PLAN_MLFQ
+#endif
+
+/*
+ * Utilizacion maxima de la UCP, en milesimas, que se admite para el
+ * conjunto de procesos de tiempo real (suma de presupuesto / plazo). Se
+ * deja un margen para los procesos normales.
  */
-typedef struct{
-    char *nombre; 	// nombre del mutex
-	int tipo;		// tipo del mutex (no recursivo = 0, recursivo = 1)
-	int procesos[MAX_PROC]; // Procesos con el mutex abierto
-	int procesosBloqueados[MAX_PROC]; // Procesos bloqueados en el mutex
-} mutex;
+#ifndef LIMITE_UTILIZACION
+#define LIMITE_UTILIZACION 900
+#endif
+
+/*
+ * Constantes del reparto equitativo (CFS). El tiempo virtual de un
+ * proceso avanza en cada tick (PESO_NICE_0 << 10) / peso, de modo que
+ * cada proceso recibe UCP en proporcion a su peso.
+ */
+#define NICE_MIN -10		/* valor nice mas prioritario */
+#define NICE_MAX 10		/* valor nice menos prioritario */
+#define PESO_NICE_0 1024	/* peso de un proceso con nice 0 */
+#define VTIEMPO_TICK(peso) (((long long)PESO_NICE_0 << 10) / (peso))
+#define VENTAJA_DESPERTAR (VTIEMPO_TICK(PESO_NICE_0) * TICKS_POR_RODAJA)
+				/* adelanto maximo de un proceso que
+				   se despierta sobre el minimo */
+#define GRANULARIDAD_DESPERTAR VTIEMPO_TICK(PESO_NICE_0)
+				/* ventaja minima para expulsar al
+				   actual al despertarse */
+
+/*
+ * Expulsion al despertar: un proceso que se desbloquea expulsa al que
+ * esta en ejecucion si su clase de planificacion lo prefiere (nivel mas
+ * prioritario, menor tiempo virtual...), sin esperar a que este agote
+ * su rodaja. Con -DEXPULSION_DESPERTAR=0 se desactiva.
+ */
+#ifndef EXPULSION_DESPERTAR
+#define EXPULSION_DESPERTAR 1
+#endif
+
+/*
+ * Herencia de prioridad en los mutex: el propietario de un mutex se
+ * planifica con la prioridad del mas prioritario de los procesos de su
+ * misma clase que lo esperan (el nivel en la multinivel y el valor nice
+ * en el reparto equitativo; FIFO, round robin y tiempo real no tienen
+ * prioridades que heredar). Con -DHERENCIA_PRIORIDAD=0 se desactiva.
+ */
+#ifndef HERENCIA_PRIORIDAD
+#define HERENCIA_PRIORIDAD 1
+#endif
+
+#define SIN_HERENCIA 0x7FFFFFFF	/* prioridad heredada si no hay ninguna */
+
+/* nivel en que se planifica un proceso, teniendo en cuenta la herencia */
+#define NIVEL_EFECTIVO(p) ((p)->nivel < (p)->prioridad_heredada ? \
+	(p)->nivel : (p)->prioridad_heredada)
+
+/* nice con que se planifica un proceso, teniendo en cuenta la herencia */
+#define NICE_EFECTIVO(p) ((p)->nice < (p)->prioridad_heredada ? \
+	(p)->nice : (p)->prioridad_heredada)
+
+/*
+ * Multiprocesador: con -DNUM_UCPS=n (make UCPS=n) el HAL simula n UCP,
+ * cada una con su proceso en ejecucion y su propia estructura de
+ * procesos listos. Una UCP sin listos roba uno a otra que tenga listos
+ * que no esten en ejecucion. Solo una UCP a la vez ejecuta codigo del
+ * nucleo, protegido por un cerrojo con espera activa; el nivel de
+ * interrupcion solo excluye a los manejadores de la propia UCP. Los
+ * procesos de tiempo real no se migran, y el reloj dinamico y el tiempo
+ * virtual se desactivan.
+ */
+#ifndef NUM_UCPS
+#define NUM_UCPS 1
+#endif
+
+#if NUM_UCPS > 1
+#define ID_UCP_ACTUAL ucp_actual()
+#else
+#define ID_UCP_ACTUAL 0
+#endif
+
+/*
+ * Constantes de la tabla de procesos dinamica
+ */
+#define PROCS_POR_BLOQUE 16	/* entradas que se aaden al crecer la tabla */
+#define MAX_BLOQUES_PROCS 256	/* bloques como maximo: 4096 procesos */
+#define BITS_ENTRADA 12		/* bits del id con el numero de entrada */
+#define ID_MAXIMO 0x3FFFFFFF	/* los ids son siempre positivos y, sumando
+				   1, no llegan al bit ESPERAS_MUTEX */
+
+/*
+ * Constantes de la rueda de temporizadores
+ */
+#define TAM_RUEDA 64	/* numero de ranuras (debe ser potencia de 2) */
+
+/*
+ * Reloj dinamico: sin procesos listos se suprimen las interrupciones de
+ * reloj hasta el plazo mas proximo de la rueda, o como mucho durante
+ * MAX_TICKS_PARADO ticks. Con -DRELOJ_DINAMICO=0 el reloj siempre
+ * interrumpe en cada tick.
+ */
+#ifndef RELOJ_DINAMICO
+#define RELOJ_DINAMICO 1
+#endif
+#define MAX_TICKS_PARADO TICK	/* un segundo */
+#define USEG_TICK (1000000 / TICK) /* microsegundos por tick */
+
+/*
+ * Traza del nucleo: con -DTRAZA=1 los eventos de traza.h se guardan en
+ * un anillo de TAM_TRAZA entradas que se lee con leer_traza; si el
+ * lector no llega a tiempo se sobrescriben los mas antiguos. Sin ella
+ * las llamadas a trazar no generan codigo.
+ */
+#ifndef TRAZA
+#define TRAZA 0
+#endif
+#define TAM_TRAZA 4096		/* eventos del anillo (potencia de 2) */
+#if TRAZA
+#define trazar(tipo, id, arg) registrar_evento(tipo, id, arg)
+#else
+#define trazar(tipo, id, arg)
+#endif
+
+/*
+ * Constantes de la cache de pilas. El limite se puede fijar al compilar
+ * (-DLIMITE_CACHE_PILAS=n); con 0 se desactiva la cache.
+ */
+#ifndef LIMITE_CACHE_PILAS
+#define LIMITE_CACHE_PILAS 16	/* pilas libres que se guardan como maximo */
+#endif
+
+/*
+ * Constantes de la cache de imagenes de programas. El tamao se puede
+ * fijar al compilar (-DTAM_CACHE_IMAGENES=n); con 0 se desactiva.
+ */
+#ifndef TAM_CACHE_IMAGENES
+#define TAM_CACHE_IMAGENES 8	/* imagenes distintas que se mantienen */
+#endif
+#define MAX_NOM_PROG 32		/* longitud maxima de un nombre cacheable */
+
 
 
 /*
@@ -55,24 +208,60 @@ typedef struct BCP_t {
     contexto_t contexto_regs;	/* copia de registros de UCP */
     void * pila;			/* direccin inicial de la pila */
 	BCPptr siguiente;		/* puntero a otro BCP */
+	BCPptr anterior;		/* puntero al BCP previo en la lista */
 	void *info_mem;			/* descriptor del mapa de memoria */
 
+	struct entrada_imagen_t *imagen_cache; /* entrada de la cache de imagenes */
+	struct lista_BCPs_t *cola_espera; /* cola en la que esta bloqueado */
+	struct anillo_llamsis *anillo;	/* anillo de llamadas registrado */
+	int ucp;			/* UCP en cuyos listos esta */
+
 	/**Funcion dormir**/
-	int tiempo_inicio_bloq;		/* momento de bloqueo */
-	int segundos_bloqueo;		/* nmero de segundos de bloqueo */
+	int tick_despertar;		/* tick absoluto en que debe despertar
+					   (0 si no tiene plazo pendiente) */
+	BCPptr sig_rueda;		/* siguiente en la ranura de la rueda */
+	BCPptr ant_rueda;		/* anterior en la ranura de la rueda */
 
 	/*Funcion contabilidad*/
 	int contador_sistema;		/* numero de interr. en modo sistema */
 	int contador_usuario;		/* numero de interr. en modo usuario */
+	long long ns_sistema;		/* tiempo en modo sistema (nanoseg.) */
+	long long ns_usuario;		/* tiempo en modo usuario (nanoseg.) */
 
 	/**Funcion MUTEX*/
-	
+	struct mutex_t *descriptores[NUM_MUT_PROC]; /* mutex abiertos */
+	struct mutex_t *esperando_mutex; /* mutex en cuya cola esta */
 
 	/*Round Robin*/
 	int ticksRestantes; /* nmero de ticks restantes para terminar rodaja */
 
-	/*Leer caracteres*/
-	int bloqueo_por_lectura;/* 1 indica que esta bloqueado por lectura de caracter */
+	/*Planificacion multinivel*/
+	int nivel;		/* cola de listos en la que esta (0 la mas prioritaria) */
+	int prioridad_heredada;	/* prioridad heredada de los procesos que
+				   esperan sus mutex, en la escala de su
+				   clase (SIN_HERENCIA si ninguna) */
+
+	/*Reparto equitativo*/
+	int nice;		/* valor nice (NICE_MIN..NICE_MAX) */
+	long long vtiempo;	/* tiempo virtual de ejecucion */
+	int ticks_pendientes;	/* ticks aun no sumados a vtiempo */
+	BCPptr hijo;		/* primer hijo en el monticulo de listos */
+	BCPptr hermano;		/* siguiente hermano en el monticulo */
+	BCPptr previo;		/* hermano anterior, o padre si es el primero */
+
+	/*Tiempo real (EDF)*/
+	int tiempo_real;	/* 1 si es un proceso periodico de tiempo real */
+	int periodo;		/* ticks entre dos activaciones */
+	int presupuesto;	/* ticks de UCP por periodo */
+	int plazo;		/* ticks desde la activacion hasta el plazo */
+	int utilizacion;	/* milesimas de UCP reservadas */
+	int inicio_periodo;	/* tick de activacion del periodo actual */
+	int plazo_abs;		/* tick del plazo del periodo actual */
+	int presupuesto_restante; /* ticks que le quedan en este periodo */
+	int plazo_incumplido;	/* ya contado el fallo de este periodo */
+	int periodos;		/* periodos activados */
+	int fallos_plazo;	/* periodos terminados despues del plazo */
+	int agotamientos;	/* periodos en que agoto el presupuesto */
 
 } BCP;
 
@@ -86,34 +275,225 @@ typedef struct BCP_t {
  *
  */
 
-typedef struct{
+typedef struct lista_BCPs_t{
 	BCP *primero;
 	BCP *ultimo;
 } lista_BCPs;
 
 
 /*
- * Variable global que identifica el proceso actual
+ * Operaciones de una clase de planificacion. Cada clase mantiene a su
+ * manera la estructura de procesos listos, que incluye siempre al
+ * proceso en ejecucion.
+ */
+struct UCP_t;
+
+typedef struct clase_planificacion_t {
+	char *nombre;			/* nombre con que se elige al arrancar */
+	void (*insertar)(BCP *proc);	/* pasa un proceso a listo */
+	void (*eliminar)(BCP *proc);	/* saca un proceso de listos */
+	BCP *(*elegir)();		/* proceso a ejecutar, con su rodaja
+					   ya asignada (NULL si no hay) */
+	int (*tick)(BCP *proc);		/* tick del proceso en ejecucion:
+					   1 si ha agotado su rodaja */
+	void (*ceder)(BCP *proc);	/* reencola al que agota su rodaja */
+	void (*despertar)(BCP *proc);	/* ajusta al que se desbloquea, antes
+					   de insertarlo */
+	int (*expulsa)(BCP *nuevo, BCP *actual); /* 1 si el que pasa a
+					   listo debe expulsar al actual (y
+					   lo deja para elegirlo el primero) */
+	int (*prioridad)(BCP *proc);	/* prioridad efectiva, con la heredada
+					   (menor valor, mas prioritario); NULL
+					   si la clase no tiene prioridades */
+	BCP *(*robable)(struct UCP_t *ucp); /* el listo de la UCP que se le
+					   puede robar (NULL si solo tiene el
+					   que esta en ejecucion) */
+} clase_planificacion;
+
+
+/*
+ * Estado de cada UCP: el proceso en ejecucion, las estructuras de listos
+ * de todas las clases de planificacion y lo que debe conservarse
+ * mientras ejecuta en modo usuario o sin procesos.
+ */
+typedef struct UCP_t {
+	BCP *actual;		/* proceso en ejecucion (el ultimo que ha
+				   ejecutado si no hay listos) */
+	int inactiva;		/* 1 si espera sin listos */
+
+	/* interrupcion software pendiente: proceso al que va dirigida y si
+	   se debe a que otro que pasa a listo le expulsa, y no a que haya
+	   agotado su rodaja */
+	int id_int_soft;
+	int expulsion_pendiente;
+	int int_sw_pedida;	/* otra UCP pide la int. SW (ver int_ipi) */
+
+	/* contabilidad precisa: instante (en nanosegundos) desde el que aun
+	   no se ha cargado tiempo al proceso actual, y si es de sistema */
+	long long marca_cuenta;
+	int cuenta_en_sistema;
+
+	lista_BCPs cola_listos;	/* FIFO y round robin */
+
+	/* multinivel: una cola por nivel (el 0 el mas prioritario) y mapa de
+	   bits de las no vacias */
+	lista_BCPs colas_listos[NUM_COLAS_LISTOS];
+	unsigned int mapa_listos;
+	int proximo_envejecimiento; /* tick a partir del cual toca el
+				   siguiente envejecimiento (numTicks
+				   avanza a saltos con el reloj dinamico
+				   y el tiempo virtual) */
+
+	/* reparto equitativo: monticulo por tiempo virtual y minimo tiempo
+	   virtual de los listos (no decrece nunca) */
+	BCP *raiz_listos;
+	long long vtiempo_minimo;
+
+	lista_BCPs cola_tiempo_real; /* por plazo absoluto */
+
+	int robados;		/* procesos que ha robado a otras UCP */
+} UCP;
+
+
+/*
+ * Entrada de la cache de imagenes: un programa ya cargado y el numero de
+ * procesos que lo estan usando.
  */
+typedef struct entrada_imagen_t {
+	char nombre[MAX_NOM_PROG+1];	/* nombre del programa ("" si libre) */
+	void *info_mem;			/* descriptor del mapa de memoria */
+	void *pc_inicial;		/* direccion de arranque del programa */
+	int referencias;		/* procesos que usan la imagen */
+	unsigned int ultimo_uso;	/* marca para el reemplazo LRU */
+} entrada_imagen;
+
+
+/*
+ * Parte de un mutex que la biblioteca de usuario modifica directamente
+ * (misma definicion que en usuario/lib/serv.c). La palabra vale 0 si el
+ * mutex esta libre y, si no, la marca de su propietario (MARCA_MUTEX),
+ * con el bit ESPERAS_MUTEX activo si hay procesos en la cola. Un proceso
+ * toma un mutex libre con una comparacion e intercambio atomica sin
+ * entrar al nucleo, y solo llama a lock o unlock si hay competencia.
+ */
+typedef struct palabra_mutex_t{
+	volatile unsigned int palabra;	// propietario y bit de esperas
+	int tipo;		// tipo del mutex (no recursivo = 0, recursivo = 1)
+	int num_bloqueos;	// veces que lo ha bloqueado el propietario
+} palabra_mutex;
+
+#define MARCA_MUTEX(proc) ((unsigned int)(proc)->id + 1)
+
+/*
+ * Definimos un mutex compuesto por su nombre, palabra compartida, numero
+ * de descriptores que lo tienen abierto y cola de procesos bloqueados.
+ */
+typedef struct mutex_t{
+	char nombre[MAX_NOM_MUT+1]; // nombre del mutex ("" si no existe)
+	palabra_mutex compartida; // estado visible desde la biblioteca
+	int abiertos;		// descriptores de procesos que lo referencian
+	lista_BCPs bloqueados;	// Cola de procesos bloqueados en el mutex
+	struct mutex_t *sig_hash; // siguiente en la cubeta o en libres
+} mutex;
+
+
+/*
+ * Variable global que representa las UCP y numero de ellas que se han
+ * podido arrancar
+ */
+UCP tabla_ucps[NUM_UCPS];
+int num_ucps = 1;
 
-BCP * p_proc_actual=NULL;
+/* UCP que ejecuta el codigo y UCP de cuyos listos forma parte un proceso */
+#define UCP_ACTUAL (&tabla_ucps[ID_UCP_ACTUAL])
+#define UCP_DE(proc) (&tabla_ucps[(proc)->ucp])
 
 /*
- * Variable global que representa la tabla de procesos
+ * Proceso actual: el que esta en ejecucion en la UCP actual
  */
+#define p_proc_actual (UCP_ACTUAL->actual)
 
-BCP tabla_procs[MAX_PROC];
+#if NUM_UCPS > 1
+/*
+ * Cerrojo del nucleo: numero de la UCP que lo tiene mas 1 (0 si libre)
+ */
+volatile int cerrojo_nucleo = 0;
+#endif
 
 /*
- * Variable global que representa la cola de procesos listos
+ * Variable global que representa la tabla de procesos: array de
+ * bloques de PROCS_POR_BLOQUE BCPs que se reservan segun se necesitan
  */
-lista_BCPs lista_listos= {NULL, NULL};
 
+BCP *tabla_procs[MAX_BLOQUES_PROCS];
+
+/*
+ * Variable global que indica el numero de bloques reservados
+ */
+int num_bloques_procs = 0;
+
+/*
+ * Variable global que representa la lista de BCPs libres
+ */
+lista_BCPs lista_libres = {NULL, NULL};
+
+/*
+ * Clase de planificacion en uso, elegida al arrancar
+ */
+clase_planificacion *clase_actual = NULL;
+
+/*
+ * Procesos de tiempo real que esperan la activacion de su periodo (los
+ * listos estan en la cola de su UCP)
+ */
+lista_BCPs lista_periodos = {NULL, NULL};
+
+/*
+ * Utilizacion de la UCP (en milesimas) reservada por los procesos de
+ * tiempo real admitidos
+ */
+int utilizacion_tiempo_real = 0;
+
+/*
+ * Peso de cada valor nice, desde NICE_MIN: cada nivel supone alrededor
+ * de un 25% mas o menos de UCP que el siguiente
+ */
+int pesos_nice[NICE_MAX - NICE_MIN + 1] = {
+	9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+	1024,
+	820, 655, 526, 423, 335, 272, 215, 172, 137, 110
+};
+
+
+/*
+ * Variable global que representa la cola de procesos bloqueados
+ * por lectura del terminal
+ */
+lista_BCPs lista_espera_terminal = {NULL, NULL};
+
+/*
+ * Rueda de temporizadores de procesos bloqueados con plazo. Cada ranura
+ * contiene los procesos cuyo tick absoluto de despertar es congruente
+ * con su indice modulo TAM_RUEDA. Las ranuras se enlazan por los campos
+ * sig_rueda y ant_rueda, de modo que un proceso puede estar a la vez en
+ * la rueda y en la cola de espera en la que esta bloqueado.
+ */
+lista_BCPs rueda_temporizadores[TAM_RUEDA];
+
+/*
+ * Procesos con plazo en la rueda y tick del plazo mas proximo, que se
+ * mantiene al poner y quitar plazos para no recorrer la rueda entera
+ * cada vez que se para el reloj (0 si hay que buscarlo, ver
+ * proximo_temporizador)
+ */
+int num_temporizadores = 0;
+int plazo_minimo = 0;
 
 /*
  * Variable global que representa la cola de procesos bloqueados
+ * por la llamada dormir
  */
-lista_BCPs lista_bloqueados = {NULL, NULL};
+lista_BCPs lista_dormidos = {NULL, NULL};
 
 /*
  * Variable global que representa el acceso a zona de usuario en memoria
@@ -126,27 +506,138 @@ int accesoParam = 0;
 int numTicks = 0;
 
 /*
-   Variable global que representa el id del proceso al que va
-   dirigida la int sw de planificacion
+ * Estadisticas de latencia de cada llamada al sistema
+ */
+struct latencias_llamsis latencias[NSERVICIOS];
+
+#if TRAZA
+#if (TAM_TRAZA & (TAM_TRAZA - 1)) != 0
+#error "TAM_TRAZA ha de ser potencia de 2"
+#endif
+/*
+ * Anillo de la traza. Los indices crecen sin limite: eventos_traza es
+ * el numero de eventos registrados y leidos_traza el de los entregados
+ * o descartados; perdidos_traza cuenta los sobrescritos sin leer.
+ */
+struct evento_traza traza[TAM_TRAZA];
+unsigned int eventos_traza = 0;
+unsigned int leidos_traza = 0;
+unsigned int perdidos_traza = 0;
+#endif
+
+/*
+ * Reloj dinamico: ticks cuya interrupcion se ha suprimido en la espera
+ * actual (0 si el reloj interrumpe en cada tick), veces que la UCP ha
+ * salido de la espera sin procesos listos y total de ticks suprimidos
+ */
+int ticks_parado = 0;
+int despertares_inactivo = 0;
+int ticks_saltados = 0;
+
+/*
+ * Tiempo virtual: arrancando con la variable de entorno TIEMPO_VIRTUAL
+ * definida, cuando todos los procesos esperan plazos el reloj salta al
+ * mas proximo en lugar de esperarlo. Ticks que se han saltado asi.
  */
-int id_int_soft = 0;
+int tiempo_virtual = 0;
+int ticks_adelantados = 0;
 
 /*
- * Buffer de caracteres procesados del terminal
+ * Buffer circular de caracteres procesados del terminal. Solo escribe en
+ * el la interrupcion de terminal (avanzando finBuffer) y solo lee de el
+ * sis_leer_caracter (avanzando inicioBuffer). Los indices crecen sin
+ * limite y se reducen con la mascara al acceder al vector.
  */
-char bufferCaracteres[TAM_BUF_TERM];
+volatile char bufferCaracteres[TAM_BUF_TERM];
+volatile unsigned int inicioBuffer = 0;
+volatile unsigned int finBuffer = 0;
+
+#if (TAM_BUF_TERM & (TAM_BUF_TERM - 1)) != 0
+#error "TAM_BUF_TERM ha de ser potencia de 2"
+#endif
+#define MASCARA_BUF_TERM (TAM_BUF_TERM - 1)
+#define caracteresEnBuffer() (finBuffer - inicioBuffer)
 
 /*
- * Variable global que indica el nmero de caracteres en el buffer
+ * Contadores de caracteres perdidos por buffer lleno y de las veces
+ * que se ha desbordado (rachas seguidas de caracteres perdidos)
  */
-int caracteresEnBuffer = 0;
+int caracteres_perdidos = 0;
+int desbordamientos_term = 0;
+int buffer_desbordado = 0;
+
+/*
+ * Tick en que llego cada caracter del buffer y latencia (en ticks)
+ * desde la pulsacion hasta que lo devuelve leer_caracter: numero de
+ * lecturas, suma y maximo
+ */
+volatile int tickCaracteres[TAM_BUF_TERM];
+int lecturas_term = 0;
+int latencia_total_term = 0;
+int latencia_maxima_term = 0;
 
 
+/*
+ * Cache de pilas de procesos terminados, lista para reutilizar
+ */
+void *cache_pilas[LIMITE_CACHE_PILAS + 1];
+
+/*
+ * Variable global que indica el numero de pilas en la cache
+ */
+int pilas_en_cache = 0;
+
+/*
+ * Pila del ultimo proceso terminado con la cache llena, que se libera
+ * cuando termina el siguiente
+ */
+void *pila_pendiente = NULL;
+
+/*
+ * Contadores de aciertos y fallos de la cache de pilas
+ */
+int aciertos_cache_pilas = 0;
+int fallos_cache_pilas = 0;
+
+/*
+ * Cache de imagenes de programas indexada por nombre
+ */
+entrada_imagen cache_imagenes[TAM_CACHE_IMAGENES + 1];
+
+/*
+ * Reloj logico para el reemplazo LRU de la cache de imagenes
+ */
+unsigned int reloj_imagenes = 0;
+
+/*
+ * Contadores de aciertos y fallos de la cache de imagenes
+ */
+int aciertos_cache_imagenes = 0;
+int fallos_cache_imagenes = 0;
+
+/*
+ * Variable global que indica el numero de procesos existentes
+ */
+int num_procesos = 0;
+
 /*
  * Array de mutex
  */
 mutex array_mutex[NUM_MUT];
 
+/*
+ * Tabla hash de los mutex existentes por nombre y lista de mutex libres,
+ * ambas enlazadas por el campo sig_hash
+ */
+mutex *hash_mutex[TAM_HASH_MUT];
+mutex *mutex_libres = NULL;
+
+/*
+ * Variable global que representa la cola de procesos bloqueados en
+ * crear_mutex a la espera de que se elimine algun mutex
+ */
+lista_BCPs lista_espera_mutex = {NULL, NULL};
+
 /*
  * Variable global que indica el nmero de mutex existentes
  */
@@ -172,6 +663,40 @@ typedef struct tiemposDejecucion {
     int sistema;
 } tiempos_ejec;
 
+/*
+ * Version extendida con los tiempos en nanosegundos. Empieza con los
+ * mismos campos que tiempos_ejec.
+ */
+typedef struct tiemposDejecucionNs {
+    int usuario;
+    int sistema;
+    long long usuario_ns;
+    long long sistema_ns;
+} tiempos_ejec_ns;
+
+/*
+ * Anillo de llamadas al sistema que registra un proceso (misma
+ * definicion que en servicios.h). El proceso escribe peticiones y avanza
+ * enviadas; entrar_anillo las ejecuta en orden, deja el resultado de
+ * cada una en su propia entrada y avanza completadas. Las llamadas que
+ * terminan o bloquean al proceso, y cerrar_mutex, se rechazan (ver
+ * admitida_en_anillo).
+ */
+#define TAM_ANILLO 32		/* entradas del anillo (potencia de 2) */
+#define MAX_ARGS_ANILLO 4	/* argumentos por peticion */
+
+struct peticion_llamsis {
+	long llamada;
+	long args[MAX_ARGS_ANILLO];
+	long resultado;
+};
+
+struct anillo_llamsis {
+	volatile unsigned int enviadas;
+	volatile unsigned int completadas;
+	struct peticion_llamsis peticiones[TAM_ANILLO];
+};
+
 
 /*
  * Prototipos de las rutinas que realizan cada llamada al sistema
@@ -190,6 +715,16 @@ int sis_lock();
 int sis_unlock();
 int sis_cerrar_mutex();
 int sis_leer_caracter();
+int sis_leer_caracteres();
+int sis_registrar_anillo();
+int sis_entrar_anillo();
+int sis_palabra_mutex();
+int sis_fijar_prioridad();
+int sis_fijar_tiempo_real();
+int sis_fin_periodo();
+int sis_tiempos_proceso_ns();
+int sis_leer_traza();
+int sis_leer_latencias();
 
 /*
  * Variable global que contiene las rutinas que realizan cada llamada
@@ -206,7 +741,17 @@ servicio tabla_servicios[NSERVICIOS]={	{
 					{sis_lock},
 					{sis_unlock},
 					{sis_cerrar_mutex},
-					{sis_leer_caracter}
+					{sis_leer_caracter},
+					{sis_leer_caracteres},
+					{sis_registrar_anillo},
+					{sis_entrar_anillo},
+					{sis_palabra_mutex},
+					{sis_fijar_prioridad},
+					{sis_fijar_tiempo_real},
+					{sis_fin_periodo},
+					{sis_tiempos_proceso_ns},
+					{sis_leer_traza},
+					{sis_leer_latencias}
 
 
 				};
@@ -0,0 +1,39 @@
+/*
+ *  minikernel/include/latencias.h
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ *
+ * Fichero de cabecera que define las estadsticas de latencia de cada
+ * llamada al sistema. Lo usan el ncleo y la biblioteca de usuario
+ * (llamada leer_latencias).
+ *
+ */
+
+#ifndef _LATENCIAS_H
+#define _LATENCIAS_H
+
+/* Cubetas de los histogramas: la i cuenta tiempos de 2^i a 2^(i+1)-1
+   nanosegundos; la ltima (desde 2^39, unos 9 minutos) incluye tambin
+   los mayores, de modo que las esperas de segundos tienen su cubeta */
+#define NUM_CUBETAS_LAT 40
+
+/*
+ * Estadsticas de una llamada. El tiempo de cada invocacin se divide
+ * en el que el proceso ha pasado en la UCP y el que ha estado
+ * bloqueado o esperando a que lo vuelvan a elegir. El histograma de
+ * tiempo bloqueado slo cuenta las invocaciones que se han bloqueado.
+ */
+struct latencias_llamsis {
+	unsigned int llamadas;
+	unsigned int bloqueos;		/* llamadas que han cedido la UCP */
+	long long max_cpu;		/* mximos en nanosegundos */
+	long long max_bloqueado;
+	unsigned int cpu[NUM_CUBETAS_LAT];
+	unsigned int bloqueado[NUM_CUBETAS_LAT];
+};
+
+#endif /* _LATENCIAS_H */
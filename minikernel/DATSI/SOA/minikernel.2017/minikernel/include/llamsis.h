@@ -19,7 +19,7 @@
 #define _LLAMSIS_H
 
 /* Numero de llamadas disponibles */
-#define NSERVICIOS 12
+#define NSERVICIOS 22
 
 #define CREAR_PROCESO 0
 #define TERMINAR_PROCESO 1
@@ -34,6 +34,25 @@
 #define UNLOCK 9
 #define CERRAR_MUTEX 10
 #define LEER_CARACTER 11
+#define LEER_CARACTERES 12
+#define REGISTRAR_ANILLO 13
+#define ENTRAR_ANILLO 14
+#define PALABRA_MUTEX 15
+#define FIJAR_PRIORIDAD 16
+#define FIJAR_TIEMPO_REAL 17
+#define FIN_PERIODO 18
+#define TIEMPOS_PROCESO_NS 19
+#define LEER_TRAZA 20
+#define LEER_LATENCIAS 21
+
+/* Nombres de las llamadas, en el orden de sus numeros */
+#define NOMBRES_LLAMSIS { \
+	"crear_proceso", "terminar_proceso", "escribir", "obtener_id_pr", \
+	"dormir", "tiempos_proceso", "crear_mutex", "abrir_mutex", "lock", \
+	"unlock", "cerrar_mutex", "leer_caracter", "leer_caracteres", \
+	"registrar_anillo", "entrar_anillo", "palabra_mutex", \
+	"fijar_prioridad", "fijar_tiempo_real", "fin_periodo", \
+	"tiempos_proceso_ns", "leer_traza", "leer_latencias" }
 
 #endif /* _LLAMSIS_H */
 
@@ -0,0 +1,43 @@
+/*
+ *  minikernel/include/traza.h
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ *
+ * Fichero de cabecera que define los eventos de la traza del ncleo.
+ * Lo usan el ncleo, la biblioteca de usuario (llamada leer_traza) y el
+ * decodificador de herramientas/, que se ejecuta en el anfitrin.
+ *
+ */
+
+#ifndef _TRAZA_H
+#define _TRAZA_H
+
+/* Tipos de evento */
+#define EV_CAMBIO 0		/* cambio de contexto: id sale, arg entra */
+#define EV_DESPERTAR 1		/* id pasa de bloqueado a listo */
+#define EV_LLAMSIS 2		/* id entra en la llamada nmero arg */
+#define EV_FIN_LLAMSIS 3	/* id sale de la llamada con resultado arg */
+#define EV_INT_RELOJ 4		/* interrupcin de reloj; arg es el tick */
+#define EV_INT_TERMINAL 5	/* interrupcin de terminal; arg es el car. */
+#define EV_INT_SW 6		/* interrupcin software de planificacin */
+#define EV_PERDIDO 7		/* carcter arg descartado: buffer lleno */
+#define NUM_EVENTOS 8
+
+/*
+ * Registro de un evento, de 16 bytes: instante en nanosegundos (reloj
+ * montono del anfitrin; 60 bits dan para aos), tipo, proceso afectado
+ * (-1 si no hay) y argumento. El identificador ocupa un int entero, ya
+ * que lleva la generacin de la entrada de la tabla de procesos.
+ */
+struct evento_traza {
+	long long tiempo:60;
+	unsigned long long tipo:4;
+	int id;
+	int arg;
+};
+
+#endif /* _TRAZA_H */
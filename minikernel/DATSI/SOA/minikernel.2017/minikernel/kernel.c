@@ -13,119 +13,1649 @@
  *
  */
 #include <string.h>
+#include <stdlib.h>
+#include <time.h>
 #include "kernel.h"	/* Contiene defs. usadas por este modulo */
 
+/*
+ *
+ * Funciones que facilitan el manejo de las listas de BCPs
+ *	insertar_ultimo insertar_primero eliminar_primero eliminar_elem
+ *
+ * Las listas son doblemente enlazadas a traves de los campos siguiente
+ * y anterior del BCP, por lo que todas las operaciones son de coste
+ * constante.
+ *
+ * NOTA: PRIMERO SE DEBE LLAMAR A eliminar Y LUEGO A insertar
+ */
+
+/*
+ * Inserta un BCP al final de la lista.
+ */
+static void insertar_ultimo(lista_BCPs *lista, BCP * proc){
+	if (lista->primero==NULL)
+		lista->primero= proc;
+	else
+		lista->ultimo->siguiente=proc;
+	proc->anterior=lista->ultimo;
+	lista->ultimo= proc;
+	proc->siguiente=NULL;
+}
+
+/*
+ * Inserta un BCP al principio de la lista.
+ */
+static void insertar_primero(lista_BCPs *lista, BCP * proc){
+	if (lista->ultimo==NULL)
+		lista->ultimo= proc;
+	else
+		lista->primero->anterior=proc;
+	proc->siguiente=lista->primero;
+	lista->primero= proc;
+	proc->anterior=NULL;
+}
+
+/*
+ * Elimina el primer BCP de la lista.
+ */
+static void eliminar_primero(lista_BCPs *lista){
+
+	if (lista->ultimo==lista->primero)
+		lista->ultimo=NULL;
+	lista->primero=lista->primero->siguiente;
+	if (lista->primero)
+		lista->primero->anterior=NULL;
+}
+
+/*
+ * Elimina un determinado BCP de la lista. El BCP debe estar en ella.
+ */
+static void eliminar_elem(lista_BCPs *lista, BCP * proc){
+	if (proc->anterior)
+		proc->anterior->siguiente=proc->siguiente;
+	else
+		lista->primero=proc->siguiente;
+
+	if (proc->siguiente)
+		proc->siguiente->anterior=proc->anterior;
+	else
+		lista->ultimo=proc->anterior;
+}
+
 /*
  *
  * Funciones relacionadas con la tabla de procesos:
- *	iniciar_tabla_proc buscar_BCP_libre
+ *	iniciar_tabla_proc crecer_tabla_proc buscar_BCP_libre liberar_BCP
+ *
+ * La tabla crece por bloques de PROCS_POR_BLOQUE entradas. Las entradas
+ * libres forman una cola FIFO, de modo que se reutilizan lo mas tarde
+ * posible, y el identificador de un proceso incluye, por encima de los
+ * BITS_ENTRADA bits del numero de entrada, la generacion de la entrada.
  *
  */
 
 /*
- * Funcin que inicia la tabla de procesos
+ * Funcin que inicia la tabla de procesos. Los bloques de entradas se
+ * reservan bajo demanda.
  */
 static void iniciar_tabla_proc(){
 	int i;
 
-	for (i=0; i<MAX_PROC; i++)
-		tabla_procs[i].estado=NO_USADA;
+	for (i=0; i<MAX_BLOQUES_PROCS; i++)
+		tabla_procs[i]=NULL;
+	num_bloques_procs=0;
+}
+
+/*
+ * Aade un bloque de entradas a la tabla de procesos y las inserta en
+ * la lista de libres. Devuelve -1 si la tabla no puede crecer mas.
+ */
+static int crecer_tabla_proc(){
+	BCP *bloque;
+	int i, base;
+
+	if (num_bloques_procs==MAX_BLOQUES_PROCS)
+		return -1;
+	bloque=malloc(PROCS_POR_BLOQUE*sizeof(BCP));
+	if (bloque==NULL)
+		return -1;
+
+	base=num_bloques_procs*PROCS_POR_BLOQUE;
+	for (i=0; i<PROCS_POR_BLOQUE; i++) {
+		bloque[i].estado=NO_USADA;
+		bloque[i].id=base+i;	/* primera generacion */
+		insertar_ultimo(&lista_libres, &bloque[i]);
+	}
+	tabla_procs[num_bloques_procs++]=bloque;
+	return 0;
+}
+
+/*
+ * Funcin que busca una entrada libre en la tabla de procesos: toma la
+ * primera de la lista de libres, haciendo crecer la tabla si no hay.
+ */
+static BCP * buscar_BCP_libre(){
+	BCP *proc;
+
+	if ((lista_libres.primero==NULL) && (crecer_tabla_proc()<0))
+		return NULL;
+	proc=lista_libres.primero;
+	eliminar_primero(&lista_libres);
+	return proc;
+}
+
+/*
+ * Devuelve el BCP de un proceso existente a partir de su identificador,
+ * o NULL si ya no existe.
+ */
+static BCP * buscar_BCP(int id){
+	int entrada=id & ((1<<BITS_ENTRADA)-1);
+	BCP *proc;
+
+	if (entrada>=num_bloques_procs*PROCS_POR_BLOQUE)
+		return NULL;
+	proc=&tabla_procs[entrada/PROCS_POR_BLOQUE][entrada%PROCS_POR_BLOQUE];
+	if ((proc->id!=id) || (proc->estado==NO_USADA))
+		return NULL;
+	return proc;
+}
+
+/*
+ * Devuelve una entrada a la lista de libres pasando a la siguiente
+ * generacion, para que su proximo identificador sea distinto.
+ */
+static void liberar_BCP(BCP * proc){
+	proc->estado=NO_USADA;
+	proc->id=(proc->id + (1<<BITS_ENTRADA)) & ID_MAXIMO;
+	insertar_ultimo(&lista_libres, proc);
+}
+
+/*
+ *
+ * Funciones relacionadas con la cache de pilas
+ *	obtener_pila devolver_pila
+ *
+ */
+
+/*
+ * Obtiene una pila para un proceso nuevo, de la cache si hay alguna.
+ * Las pilas se reservan alineadas a TAM_PILA (ver TAM_AREA_USUARIO).
+ */
+static void * obtener_pila(){
+	void *pila;
+
+	if (pilas_en_cache>0) {
+		aciertos_cache_pilas++;
+		return cache_pilas[--pilas_en_cache];
+	}
+	fallos_cache_pilas++;
+	if (posix_memalign(&pila, TAM_PILA, TAM_PILA)!=0)
+		panico("no hay memoria para la pila de un proceso");
+	return pila;
+}
+
+/*
+ * Devuelve la pila de un proceso terminado a la cache. Si la cache esta
+ * llena no puede liberarse todavia, ya que el proceso sigue ejecutando
+ * sobre ella hasta el cambio de contexto (y free puede devolver esa
+ * memoria al sistema): se libera la que quedo pendiente de la vez
+ * anterior y esta queda pendiente.
+ */
+static void devolver_pila(void *pila){
+	if (pilas_en_cache<LIMITE_CACHE_PILAS)
+		cache_pilas[pilas_en_cache++]=pila;
+	else {
+		if (pila_pendiente)
+			free(pila_pendiente);
+		pila_pendiente=pila;
+	}
+}
+
+/*
+ *
+ * Funciones relacionadas con la cache de imagenes
+ *	obtener_imagen devolver_imagen vaciar_cache_imagenes
+ *
+ * Cada entrada ocupada de la cache mantiene una imagen creada con
+ * crear_imagen, compartida por todos los procesos del mismo programa.
+ * Una entrada sin referencias sigue cargada hasta que hace falta su
+ * hueco para otro programa (se elige la usada hace mas tiempo).
+ *
+ */
+
+/*
+ * Obtiene la imagen del programa prog para el proceso proc, de la cache
+ * si esta cargado. Si el nombre es demasiado largo, o todas las entradas
+ * estan en uso, crea una imagen propia del proceso fuera de la cache.
+ */
+static void * obtener_imagen(char *prog, void **pc_inicial, BCP * proc){
+	entrada_imagen *ent, *libre=NULL;
+	void *imagen;
+	int i;
+
+	proc->imagen_cache=NULL;
+	if (strlen(prog)<=MAX_NOM_PROG) {
+		for (i=0; i<TAM_CACHE_IMAGENES; i++) {
+			ent=&cache_imagenes[i];
+			if (strcmp(ent->nombre, prog)==0) {
+				aciertos_cache_imagenes++;
+				ent->referencias++;
+				ent->ultimo_uso=++reloj_imagenes;
+				proc->imagen_cache=ent;
+				*pc_inicial=ent->pc_inicial;
+				return ent->info_mem;
+			}
+			/* candidata: la libre o la no usada mas antigua */
+			if ((ent->referencias==0) && ((libre==NULL) ||
+			    (ent->ultimo_uso<libre->ultimo_uso)))
+				libre=ent;
+		}
+	}
+	fallos_cache_imagenes++;
+
+	imagen=crear_imagen(prog, pc_inicial);
+	if ((imagen==NULL) || (libre==NULL))
+		return imagen;
+
+	/* expulsa a la anterior ocupante, si la habia */
+	if (libre->nombre[0]!='\0')
+		liberar_imagen(libre->info_mem);
+
+	strcpy(libre->nombre, prog);
+	libre->info_mem=imagen;
+	libre->pc_inicial=*pc_inicial;
+	libre->referencias=1;
+	libre->ultimo_uso=++reloj_imagenes;
+	proc->imagen_cache=libre;
+	return imagen;
+}
+
+/*
+ * Suelta la referencia del proceso a su imagen. Las imagenes de la cache
+ * siguen cargadas; las propias del proceso se liberan.
+ */
+static void devolver_imagen(BCP * proc){
+	if (proc->imagen_cache)
+		proc->imagen_cache->referencias--;
+	else
+		liberar_imagen(proc->info_mem);
+}
+
+/*
+ * Libera todas las imagenes de la cache. Se usa cuando termina el
+ * ultimo proceso: al liberar la ultima imagen el sistema se para.
+ */
+static void vaciar_cache_imagenes(){
+	int i;
+
+	for (i=0; i<TAM_CACHE_IMAGENES; i++)
+		if (cache_imagenes[i].nombre[0]!='\0') {
+			cache_imagenes[i].nombre[0]='\0';
+			liberar_imagen(cache_imagenes[i].info_mem);
+		}
+}
+
+/*
+ * Muestra los contadores internos del sistema. Se invoca al terminar el
+ * ultimo proceso, justo antes de que se pare el sistema.
+ */
+static void mostrar_estadisticas(){
+	int i;
+
+	printk("-> ESTADISTICAS: cache de pilas: %d aciertos, %d fallos\n",
+			aciertos_cache_pilas, fallos_cache_pilas);
+	printk("-> ESTADISTICAS: cache de imagenes: %d aciertos, %d fallos\n",
+			aciertos_cache_imagenes, fallos_cache_imagenes);
+	printk("-> ESTADISTICAS: terminal: %d caracteres perdidos en %d desbordamientos\n",
+			caracteres_perdidos, desbordamientos_term);
+	if (lecturas_term)
+		printk("-> ESTADISTICAS: terminal: latencia de leer_caracter: media %d.%02d ticks, maxima %d ticks (%d lecturas)\n",
+				latencia_total_term / lecturas_term,
+				latencia_total_term * 100 / lecturas_term % 100,
+				latencia_maxima_term, lecturas_term);
+	printk("-> ESTADISTICAS: planificacion %s\n", clase_actual->nombre);
+	printk("-> ESTADISTICAS: inactivo: %d despertares, %d ticks sin interrupcion de reloj\n",
+			despertares_inactivo, ticks_saltados);
+	if (tiempo_virtual)
+		printk("-> ESTADISTICAS: tiempo virtual: %d ticks adelantados\n",
+				ticks_adelantados);
+	if (num_ucps > 1)
+		for (i=0; i<num_ucps; i++)
+			printk("-> ESTADISTICAS: UCP %d: %d procesos robados\n",
+					i, tabla_ucps[i].robados);
+#if TRAZA
+	printk("-> ESTADISTICAS: traza: %u eventos, %u sobrescritos sin leer\n",
+			eventos_traza, perdidos_traza);
+#endif
+}
+
+/*
+ *
+ * Funciones del monticulo de emparejamiento de procesos listos, usado
+ * por el reparto equitativo
+ *	fusionar_mont fusionar_hermanos insertar_mont eliminar_mont
+ *
+ * Cada nodo apunta a su primer hijo, a su siguiente hermano y a su
+ * hermano anterior (o a su padre si es el primer hijo), lo que permite
+ * sacar cualquier proceso, no solo el de menor tiempo virtual.
+ *
+ */
+
+/*
+ * Fusiona dos monticulos cuyas raices no tienen hermanos. La de mayor
+ * tiempo virtual pasa a ser el primer hijo de la otra.
+ */
+static BCP * fusionar_mont(BCP *a, BCP *b){
+	BCP *aux;
+
+	if (a==NULL)
+		return b;
+	if (b==NULL)
+		return a;
+	if (b->vtiempo < a->vtiempo) {
+		aux=a; a=b; b=aux;
+	}
+	b->hermano=a->hijo;
+	if (a->hijo)
+		a->hijo->previo=b;
+	b->previo=a;
+	a->hijo=b;
+	return a;
+}
+
+/*
+ * Fusiona una lista de hermanos en un solo monticulo en dos pasadas:
+ * por parejas de izquierda a derecha y luego el resultado de derecha a
+ * izquierda.
+ */
+static BCP * fusionar_hermanos(BCP *primero){
+	BCP *a, *b, *sig, *pares=NULL, *res=NULL;
+
+	while (primero) {
+		a=primero;
+		b=a->hermano;
+		sig=b ? b->hermano : NULL;
+		a->hermano=a->previo=NULL;
+		if (b)
+			b->hermano=b->previo=NULL;
+		a=fusionar_mont(a, b);
+		a->hermano=pares;	/* pila de parejas ya fusionadas */
+		pares=a;
+		primero=sig;
+	}
+	while (pares) {
+		sig=pares->hermano;
+		pares->hermano=NULL;
+		res=fusionar_mont(res, pares);
+		pares=sig;
+	}
+	return res;
+}
+
+/*
+ * Inserta un proceso en el monticulo de listos de su UCP.
+ */
+static void insertar_mont(BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+
+	proc->hijo=proc->hermano=proc->previo=NULL;
+	ucp->raiz_listos=fusionar_mont(ucp->raiz_listos, proc);
+}
+
+/*
+ * Saca un proceso cualquiera del monticulo de listos: se desengancha su
+ * subarbol, se quita el proceso y sus hijos se vuelven a fusionar.
+ */
+static void eliminar_mont(BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+
+	if (proc==ucp->raiz_listos) {
+		ucp->raiz_listos=fusionar_hermanos(proc->hijo);
+		return;
+	}
+	if (proc->previo->hijo==proc)
+		proc->previo->hijo=proc->hermano;
+	else
+		proc->previo->hermano=proc->hermano;
+	if (proc->hermano)
+		proc->hermano->previo=proc->previo;
+	ucp->raiz_listos=fusionar_mont(ucp->raiz_listos,
+			fusionar_hermanos(proc->hijo));
+}
+
+/*
+ *
+ * Clases de planificacion
+ *	consumir_rodaja fifo_* rr_* mlfq_* cfs_*
+ *
+ * Cada politica es una tabla de operaciones (clase_planificacion) y
+ * guarda sus procesos listos en su propia estructura: una cola FIFO y
+ * round robin, una cola por nivel la multinivel y un monticulo el
+ * reparto equitativo. Cada UCP tiene sus estructuras: un proceso se
+ * inserta y se saca de las de su UCP y se elige de las de la UCP
+ * actual. El resto del nucleo solo usa la clase actual, que se elige al
+ * arrancar.
+ *
+ */
+
+/*
+ * Activa la interrupcion software en una UCP: directamente si es la
+ * actual y, si no, pidiendosela con una interrupcion entre UCP.
+ */
+static void activar_int_SW_ucp(UCP * ucp){
+	if (ucp==UCP_ACTUAL)
+		activar_int_SW();
+	else {
+		ucp->int_sw_pedida = 1;
+		activar_IPI(ucp - tabla_ucps);
+	}
+}
+
+/*
+ * Pide la interrupcion software que expulsa al proceso en ejecucion en
+ * una UCP en favor de otro que acaba de pasar a listo en ella
+ */
+static void expulsar_actual(UCP * ucp){
+	ucp->id_int_soft = ucp->actual->id;
+	ucp->expulsion_pendiente = 1;
+	activar_int_SW_ucp(ucp);
+}
+
+/*
+ * Descuenta un tick de la rodaja del proceso. Devuelve 1 si la ha
+ * agotado.
+ */
+static int consumir_rodaja(BCP * proc){
+	if (proc->ticksRestantes <= 1)
+		return 1;
+	proc->ticksRestantes--;
+	return 0;
+}
+
+/*
+ * FIFO: el proceso elegido ejecuta hasta que se bloquea o termina
+ */
+static void fifo_insertar(BCP * proc){
+	insertar_ultimo(&UCP_DE(proc)->cola_listos, proc);
+}
+
+static void fifo_eliminar(BCP * proc){
+	eliminar_elem(&UCP_DE(proc)->cola_listos, proc);
+}
+
+static BCP * fifo_elegir(){
+	return UCP_ACTUAL->cola_listos.primero;
+}
+
+static int fifo_tick(BCP * proc){
+	return 0;
+}
+
+static void fifo_ceder(BCP * proc){
+	fifo_eliminar(proc);
+	fifo_insertar(proc);
+}
+
+static void fifo_despertar(BCP * proc){
+}
+
+static int fifo_expulsa(BCP * nuevo, BCP * actual){
+	return 0;
+}
+
+/*
+ * Se roba el primero de la cola que no esta en ejecucion
+ */
+static BCP * fifo_robable(UCP * ucp){
+	BCP *proceso = ucp->cola_listos.primero;
+
+	if (proceso && proceso==ucp->actual)
+		proceso = proceso->siguiente;
+	return proceso;
+}
+
+/*
+ * Round robin: la misma cola que FIFO, con rodajas de TICKS_POR_RODAJA
+ */
+static BCP * rr_elegir(){
+	BCP *proceso = UCP_ACTUAL->cola_listos.primero;
+
+	if (proceso)
+		proceso->ticksRestantes = TICKS_POR_RODAJA;
+	return proceso;
+}
+
+static int rr_tick(BCP * proc){
+	return consumir_rodaja(proc);
+}
+
+/*
+ * El que se despierta ha ejecutado hace mas que el actual: le expulsa
+ * si este ya ha consumido algo de su rodaja, adelantandolo a la cabeza
+ * de la cola para que sea el siguiente en ejecutar
+ */
+static int rr_expulsa(BCP * nuevo, BCP * actual){
+	if (actual->ticksRestantes >= TICKS_POR_RODAJA)
+		return 0;
+	eliminar_elem(&UCP_DE(nuevo)->cola_listos, nuevo);
+	insertar_primero(&UCP_DE(nuevo)->cola_listos, nuevo);
+	return 1;
+}
+
+/*
+ * Multinivel con realimentacion. Un proceso se inserta al final de la
+ * cola de su nivel efectivo y el mapa de bits indica las colas no
+ * vacias.
+ */
+static void mlfq_insertar(BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+	int nivel=NIVEL_EFECTIVO(proc);
+
+	insertar_ultimo(&ucp->colas_listos[nivel], proc);
+	ucp->mapa_listos |= (1U << nivel);
+}
+
+static void mlfq_eliminar(BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+	int nivel=NIVEL_EFECTIVO(proc);
+	lista_BCPs *cola=&ucp->colas_listos[nivel];
+
+	eliminar_elem(cola, proc);
+	if (cola->primero==NULL)
+		ucp->mapa_listos &= ~(1U << nivel);
+}
+
+/*
+ * Elige el primero de la cola no vacia mas prioritaria y le asigna la
+ * rodaja de su nivel
+ */
+static BCP * mlfq_elegir(){
+	UCP *ucp=UCP_ACTUAL;
+	BCP *proceso;
+
+	if (ucp->mapa_listos==0)
+		return NULL;
+	proceso = ucp->colas_listos[__builtin_ffs(ucp->mapa_listos)-1].primero;
+	proceso->ticksRestantes = RODAJA_NIVEL(NIVEL_EFECTIVO(proceso));
+	return proceso;
+}
+
+/*
+ * Envejecimiento periodico: todos los procesos listos de la UCP pasan
+ * al nivel 0 para que ninguno sufra inanicion.
+ */
+static void envejecer(UCP * ucp){
+	lista_BCPs *colas_listos=ucp->colas_listos;
+	int i;
+	BCP *paux;
+
+	for (i=1; i<NUM_COLAS_LISTOS; i++) {
+		if (colas_listos[i].primero==NULL)
+			continue;
+		for (paux=colas_listos[i].primero; paux; paux=paux->siguiente)
+			paux->nivel=0;
+
+		/* concatena la cola i al final de la cola 0 */
+		if (colas_listos[0].primero==NULL)
+			colas_listos[0].primero=colas_listos[i].primero;
+		else
+			colas_listos[0].ultimo->siguiente=colas_listos[i].primero;
+		colas_listos[i].primero->anterior=colas_listos[0].ultimo;
+		colas_listos[0].ultimo=colas_listos[i].ultimo;
+		colas_listos[i].primero=colas_listos[i].ultimo=NULL;
+	}
+	if (ucp->mapa_listos)
+		ucp->mapa_listos=1;
+}
+
+static int mlfq_tick(BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+
+	if (numTicks >= ucp->proximo_envejecimiento) {
+		envejecer(ucp);
+		ucp->proximo_envejecimiento = numTicks + PERIODO_ENVEJECIMIENTO;
+	}
+	return consumir_rodaja(proc);
+}
+
+/*
+ * Un proceso que agota su rodaja baja un nivel y va al final de su
+ * nueva cola
+ */
+static void mlfq_ceder(BCP * proc){
+	mlfq_eliminar(proc);
+	if (proc->nivel<NUM_COLAS_LISTOS-1)
+		proc->nivel++;
+	mlfq_insertar(proc);
+}
+
+/*
+ * Un proceso que se desbloquea sube un nivel
+ */
+static void mlfq_despertar(BCP * proc){
+	if (proc->nivel>0)
+		proc->nivel--;
+}
+
+static int mlfq_expulsa(BCP * nuevo, BCP * actual){
+	return NIVEL_EFECTIVO(nuevo) < NIVEL_EFECTIVO(actual);
+}
+
+static int mlfq_prioridad(BCP * proc){
+	return NIVEL_EFECTIVO(proc);
+}
+
+/*
+ * Se roba el mas prioritario que no esta en ejecucion
+ */
+static BCP * mlfq_robable(UCP * ucp){
+	BCP *proceso;
+	int i;
+
+	for (i=0; i<NUM_COLAS_LISTOS; i++) {
+		proceso = ucp->colas_listos[i].primero;
+		if (proceso && proceso==ucp->actual)
+			proceso = proceso->siguiente;
+		if (proceso)
+			return proceso;
+	}
+	return NULL;
+}
+
+/*
+ * Reparto equitativo: los listos estan en el monticulo ordenado por
+ * tiempo virtual. Al sacar un proceso se le suma el tiempo virtual de
+ * los ticks que ha ejecutado (mientras esta en el monticulo su clave no
+ * cambia).
+ */
+static void cfs_insertar(BCP * proc){
+	insertar_mont(proc);
+}
+
+static void cfs_eliminar(BCP * proc){
+	eliminar_mont(proc);
+	proc->vtiempo += proc->ticks_pendientes *
+		VTIEMPO_TICK(pesos_nice[NICE_EFECTIVO(proc) - NICE_MIN]);
+	proc->ticks_pendientes = 0;
+}
+
+/*
+ * Elige el de menor tiempo virtual, la raiz del monticulo
+ */
+static BCP * cfs_elegir(){
+	UCP *ucp=UCP_ACTUAL;
+	BCP *proceso = ucp->raiz_listos;
+
+	if (proceso==NULL)
+		return NULL;
+	if (proceso->vtiempo > ucp->vtiempo_minimo)
+		ucp->vtiempo_minimo = proceso->vtiempo;
+	proceso->ticksRestantes = TICKS_POR_RODAJA;
+	return proceso;
+}
+
+static int cfs_tick(BCP * proc){
+	proc->ticks_pendientes++;
+	return consumir_rodaja(proc);
+}
+
+static void cfs_ceder(BCP * proc){
+	cfs_eliminar(proc);
+	cfs_insertar(proc);
+}
+
+/*
+ * Un proceso que llevaba tiempo bloqueado entra con un tiempo virtual
+ * poco menor que el minimo, para que no acapare la UCP
+ */
+static void cfs_despertar(BCP * proc){
+	long long minimo = UCP_DE(proc)->vtiempo_minimo;
+
+	if (proc->vtiempo < minimo - VENTAJA_DESPERTAR)
+		proc->vtiempo = minimo - VENTAJA_DESPERTAR;
+}
+
+/*
+ * Expulsa al actual si su tiempo virtual, contando los ticks que aun no
+ * se le han sumado, supera en mas de GRANULARIDAD_DESPERTAR al del que
+ * se despierta
+ */
+static int cfs_expulsa(BCP * nuevo, BCP * actual){
+	long long vtiempo_actual = actual->vtiempo + actual->ticks_pendientes *
+		VTIEMPO_TICK(pesos_nice[NICE_EFECTIVO(actual) - NICE_MIN]);
+
+	return nuevo->vtiempo + GRANULARIDAD_DESPERTAR < vtiempo_actual;
+}
+
+/*
+ * La prioridad que se hereda es el peso: el propietario de un mutex
+ * avanza su tiempo virtual al ritmo del que lo espera
+ */
+static int cfs_prioridad(BCP * proc){
+	return NICE_EFECTIVO(proc);
+}
+
+/*
+ * Se roba la raiz o, si esta en ejecucion, el hijo suyo de menor tiempo
+ * virtual, que es el siguiente que se elegiria
+ */
+static BCP * cfs_robable(UCP * ucp){
+	BCP *proceso = ucp->raiz_listos, *hijo, *mejor = NULL;
+
+	if (proceso==NULL || proceso!=ucp->actual)
+		return proceso;
+	for (hijo=proceso->hijo; hijo; hijo=hijo->hermano)
+		if (mejor==NULL || hijo->vtiempo < mejor->vtiempo)
+			mejor = hijo;
+	return mejor;
+}
+
+/*
+ * Tiempo real: los procesos periodicos admitidos por fijar_tiempo_real
+ * estan en una cola ordenada por plazo absoluto (EDF) de su UCP y se
+ * ejecutan antes que los de la clase actual. Cada periodo dispone de un
+ * presupuesto de ticks; si lo agota, el proceso espera al siguiente
+ * periodo en lista_periodos, con un plazo en la rueda de temporizadores.
+ */
+
+static void poner_temporizador(int tick);
+
+/*
+ * Comienza un nuevo periodo del proceso, activado en el tick inicio
+ */
+static void nuevo_periodo(BCP * proc, int inicio){
+	proc->inicio_periodo = inicio;
+	proc->plazo_abs = inicio + proc->plazo;
+	proc->presupuesto_restante = proc->presupuesto;
+	proc->plazo_incumplido = 0;
+	proc->periodos++;
+}
+
+/*
+ * Cuenta, una sola vez por periodo, que el proceso ha pasado su plazo
+ */
+static void comprobar_plazo(BCP * proc){
+	if (!proc->plazo_incumplido && numTicks > proc->plazo_abs) {
+		proc->plazo_incumplido = 1;
+		proc->fallos_plazo++;
+	}
+}
+
+static int edf_expulsa(BCP * nuevo, BCP * actual){
+	return nuevo->plazo_abs < actual->plazo_abs;
+}
+
+/*
+ * Inserta por plazo absoluto, detras de los de igual plazo. Si el
+ * proceso en ejecucion en su UCP no es de tiempo real o tiene un plazo
+ * posterior, se le expulsa con una interrupcion software.
+ */
+static void edf_insertar(BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+	BCP *paux, *actual=ucp->actual;
+
+	for (paux=ucp->cola_tiempo_real.primero; paux; paux=paux->siguiente)
+		if (proc->plazo_abs < paux->plazo_abs)
+			break;
+	if (paux==NULL)
+		insertar_ultimo(&ucp->cola_tiempo_real, proc);
+	else {
+		proc->siguiente=paux;
+		proc->anterior=paux->anterior;
+		if (paux->anterior)
+			paux->anterior->siguiente=proc;
+		else
+			ucp->cola_tiempo_real.primero=proc;
+		paux->anterior=proc;
+	}
+
+	if (actual && actual!=proc &&
+	    actual->estado==LISTO && (!actual->tiempo_real ||
+	    edf_expulsa(proc, actual)))
+		expulsar_actual(ucp);
+}
+
+static void edf_eliminar(BCP * proc){
+	eliminar_elem(&UCP_DE(proc)->cola_tiempo_real, proc);
+}
+
+static BCP * edf_elegir(){
+	return UCP_ACTUAL->cola_tiempo_real.primero;
+}
+
+/*
+ * Descuenta el tick del presupuesto del periodo: al agotarlo se pide
+ * la interrupcion software que lo retira hasta el siguiente periodo
+ */
+static int edf_tick(BCP * proc){
+	comprobar_plazo(proc);
+	return --proc->presupuesto_restante <= 0;
+}
+
+/*
+ * El proceso ha agotado su presupuesto: espera bloqueado la activacion
+ * del siguiente periodo o, si ya ha pasado, empieza uno nuevo. Como el
+ * plazo no es posterior al fin del periodo, el trabajo de este periodo
+ * ya no puede terminar a tiempo y se cuenta como plazo incumplido.
+ */
+static void edf_ceder(BCP * proc){
+	int siguiente = proc->inicio_periodo + proc->periodo;
+
+	if (proc->presupuesto_restante > 0)
+		return;
+	proc->agotamientos++;
+	if (!proc->plazo_incumplido) {
+		proc->plazo_incumplido = 1;
+		proc->fallos_plazo++;
+	}
+	edf_eliminar(proc);
+	if (siguiente <= numTicks) {
+		nuevo_periodo(proc, siguiente);
+		edf_insertar(proc);
+		return;
+	}
+	proc->estado = BLOQUEADO;
+	insertar_ultimo(&lista_periodos, proc);
+	proc->cola_espera = &lista_periodos;
+	poner_temporizador(siguiente);
+}
+
+/*
+ * Solo la activacion de un periodo renueva el presupuesto, no el fin de
+ * otras esperas
+ */
+static void edf_despertar(BCP * proc){
+	if (proc->cola_espera==&lista_periodos)
+		nuevo_periodo(proc, proc->inicio_periodo + proc->periodo);
+}
+
+static clase_planificacion clase_tiempo_real={
+	"edf", edf_insertar, edf_eliminar, edf_elegir, edf_tick,
+	edf_ceder, edf_despertar, edf_expulsa, NULL, NULL
+};
+
+/*
+ * Clase de planificacion de un proceso: la de tiempo real o la actual
+ */
+static clase_planificacion * clase_de(BCP * proc){
+	return proc->tiempo_real ? &clase_tiempo_real : clase_actual;
+}
+
+/*
+ * Muestra los contadores de un proceso de tiempo real que termina y
+ * libera la utilizacion que tenia reservada
+ */
+static void terminar_tiempo_real(BCP * proc){
+	printk("-> TIEMPO REAL: proceso %d: %d periodos, %d plazos incumplidos, %d presupuestos agotados\n",
+			proc->id, proc->periodos, proc->fallos_plazo,
+			proc->agotamientos);
+	utilizacion_tiempo_real -= proc->utilizacion;
+}
+
+/*
+ * Tabla de clases de planificacion, en el orden de las constantes PLAN_*
+ */
+static clase_planificacion clases_planificacion[NUM_PLANIFICACIONES]={
+	{"mlfq", mlfq_insertar, mlfq_eliminar, mlfq_elegir, mlfq_tick,
+		mlfq_ceder, mlfq_despertar, mlfq_expulsa, mlfq_prioridad,
+		mlfq_robable},
+	{"cfs", cfs_insertar, cfs_eliminar, cfs_elegir, cfs_tick,
+		cfs_ceder, cfs_despertar, cfs_expulsa, cfs_prioridad,
+		cfs_robable},
+	{"fifo", fifo_insertar, fifo_eliminar, fifo_elegir, fifo_tick,
+		fifo_ceder, fifo_despertar, fifo_expulsa, NULL, fifo_robable},
+	{"rr", fifo_insertar, fifo_eliminar, rr_elegir, rr_tick,
+		fifo_ceder, fifo_despertar, rr_expulsa, NULL, fifo_robable}
+};
+
+/*
+ * Elige la clase de planificacion: la que indique la variable de
+ * entorno PLANIFICACION (mlfq, cfs, fifo o rr) o, si no esta definida,
+ * la fijada al compilar.
+ */
+static void elegir_clase(){
+	char *nombre=getenv("PLANIFICACION");
+	int i;
+
+	clase_actual=&clases_planificacion[PLANIFICACION];
+	if (nombre==NULL)
+		return;
+	for (i=0; i<NUM_PLANIFICACIONES; i++)
+		if (strcmp(nombre, clases_planificacion[i].nombre)==0) {
+			clase_actual=&clases_planificacion[i];
+			return;
+		}
+	printk("-> PLANIFICACION %s DESCONOCIDA: SE USA %s\n", nombre,
+			clase_actual->nombre);
+}
+
+/*
+ *
+ * Funciones del cerrojo del nucleo
+ *	tomar_nucleo soltar_nucleo
+ *
+ * Con varias UCP el nucleo se protege con un unico cerrojo con espera
+ * activa. Cada manejador lo toma al empezar, salvo que su UCP ya lo
+ * tenga (interrupcion anidada dentro del nucleo), y lo suelta al
+ * terminar si lo ha tomado. El cerrojo es de la UCP y no del proceso:
+ * en un cambio de contexto lo conserva la UCP y lo suelta el proceso
+ * que entra al volver a modo usuario, o al arrancar si es nuevo (ver
+ * arranque_proceso). La espera sin listos lo suelta mientras la UCP
+ * esta parada. Con una sola UCP no hay cerrojo.
+ *
+ * Es un cerrojo unico a proposito: todo el nucleo se escribio para una
+ * UCP que se protege inhibiendo interrupciones, y con el cerrojo cada
+ * manejador sigue viendo el nucleo como si fuera el unico. Se mantiene
+ * ademas la inhibicion local, que evita que una interrupcion de la propia
+ * UCP se cuele en mitad del tratamiento. El precio es que las llamadas,
+ * los cambios de proceso y los robos de todas las UCP se serializan: solo
+ * escalan los procesos que pasan la mayor parte del tiempo en modo
+ * usuario, como los de prueba_RR2.
+ *
+ */
+
+#if NUM_UCPS > 1
+/*
+ * Toma el cerrojo si no lo tiene ya la UCP actual. Devuelve 1 si lo ha
+ * tomado.
+ */
+static int tomar_nucleo(){
+	int yo = ucp_actual() + 1;
+
+	if (cerrojo_nucleo==yo)
+		return 0;
+	while (!__sync_bool_compare_and_swap(&cerrojo_nucleo, 0, yo))
+		while (cerrojo_nucleo!=0)
+			pausa_ucp();	/* espera sin escribir en el cerrojo */
+	return 1;
+}
+
+static void soltar_nucleo(){
+	__sync_lock_release(&cerrojo_nucleo);
+}
+#else
+static int tomar_nucleo(){
+	return 0;
+}
+
+static void soltar_nucleo(){
+}
+#endif
+
+/*
+ *
+ * Funciones relacionadas con la planificacion
+ *	espera_int robar_proceso planificador
+ */
+
+static int parar_reloj();
+static int adelantar_reloj();
+
+/*
+ * Espera a que se produzca una interrupcion. Con el reloj dinamico, las
+ * interrupciones de reloj se suprimen hasta el plazo mas proximo; si ya
+ * ha llegado alguna interrupcion al bajar el nivel, no se para la UCP.
+ * En modo de tiempo virtual, si solo se espera a plazos, se salta
+ * directamente al tick del mas proximo sin esperar. Con varias UCP se
+ * deja el nucleo a las demas durante la espera; como al volver puede
+ * estar en otra UCP (si se ha expulsado y luego robado al proceso en
+ * cuya pila se espera), la UCP actual se consulta cada vez.
+ */
+static void espera_int(){
+	int nivel, parado=0;
+
+	/*printk("-> NO HAY LISTOS. ESPERA INT\n");*/
+	nivel=fijar_nivel_int(NIVEL_3);
+	if (tiempo_virtual && adelantar_reloj()) {
+		fijar_nivel_int(nivel);
+		return;
+	}
+	if (RELOJ_DINAMICO && num_ucps==1)
+		parado=parar_reloj();
+
+	/* Baja al mnimo el nivel de interrupcin mientras espera */
+	UCP_ACTUAL->inactiva=1;
+	soltar_nucleo();
+	fijar_nivel_int(NIVEL_1);
+	if (!parado || ticks_parado)
+		halt();
+	fijar_nivel_int(NIVEL_3);
+	tomar_nucleo();
+	UCP_ACTUAL->inactiva=0;
+	despertares_inactivo++;
+	fijar_nivel_int(nivel);
+}
+
+/*
+ * Busca, empezando por la UCP siguiente a la actual, un proceso listo
+ * que no este en ejecucion, lo pasa a los listos de la UCP actual y lo
+ * elige. Devuelve NULL si no hay ninguno (siempre con una sola UCP).
+ */
+static BCP * robar_proceso(){
+	int i, lvl_interrupciones, actual=ID_UCP_ACTUAL;
+	UCP *origen, *destino=&tabla_ucps[actual];
+	BCP *proceso;
+
+	for (i=1; i<num_ucps; i++) {
+		origen=&tabla_ucps[(actual+i) % num_ucps];
+		if ((proceso=clase_actual->robable(origen))==NULL)
+			continue;
+
+		lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+		clase_actual->eliminar(proceso);
+		/* el tiempo virtual es relativo al minimo de cada UCP */
+		proceso->vtiempo += destino->vtiempo_minimo -
+			origen->vtiempo_minimo;
+		proceso->ucp=actual;
+		clase_actual->insertar(proceso);
+		fijar_nivel_int(lvl_interrupciones);
+		destino->robados++;
+		return clase_actual->elegir();
+	}
+	return NULL;
+}
+
+/*
+ * Funcin de planificacion: elige el proceso de tiempo real de plazo
+ * mas proximo o, si no hay, el que indique la clase de planificacion
+ * actual o el que se pueda robar a otra UCP, esperando si no hay
+ * ninguno listo.
+ */
+static BCP * planificador(){
+	BCP *proceso;
+
+	while ((proceso=clase_tiempo_real.elegir())==NULL &&
+	       (proceso=clase_actual->elegir())==NULL &&
+	       (proceso=robar_proceso())==NULL)
+		espera_int();		/* No hay nada que hacer */
+
+	return proceso;
+}
+
+/*
+ *
+ * Funciones de la traza del nucleo
+ *	ahora_ns registrar_evento
+ *
+ */
+
+/*
+ * Instante actual en nanosegundos del reloj monotono del anfitrion.
+ */
+static long long ahora_ns(){
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+#if TRAZA
+/*
+ * Guarda un evento en el anillo. La entrada se reserva con un solo
+ * incremento atomico, por lo que una interrupcion que registre otro
+ * evento a mitad no pisa este.
+ */
+static void registrar_evento(int tipo, int id, int arg){
+	struct evento_traza *ev;
+
+	ev = &traza[__sync_fetch_and_add(&eventos_traza, 1) & (TAM_TRAZA - 1)];
+	ev->tiempo = ahora_ns();
+	ev->tipo = tipo;
+	ev->id = id;
+	ev->arg = arg;
+}
+#endif
+
+/*
+ *
+ * Funciones de contabilidad precisa de tiempos
+ *	iniciar_cuenta cargar_tiempo cambiar_proceso
+ *
+ * El tiempo transcurrido desde marca_cuenta se carga al proceso actual,
+ * como de sistema o de usuario, al entrar y salir de cada llamada y en
+ * cada cambio de contexto. La espera sin procesos listos no se carga a
+ * ningun proceso.
+ *
+ */
+
+/*
+ * Empieza a contar tiempo de usuario para el proceso que va a ejecutar.
+ */
+static void iniciar_cuenta(){
+	UCP *ucp=UCP_ACTUAL;
+
+	ucp->marca_cuenta = ahora_ns();
+	ucp->cuenta_en_sistema = 0;
+}
+
+/*
+ * Carga al proceso el tiempo transcurrido desde la ultima marca.
+ */
+static void cargar_tiempo(BCP * proc){
+	UCP *ucp=UCP_ACTUAL;
+	long long ahora = ahora_ns();
+
+	if (ucp->cuenta_en_sistema)
+		proc->ns_sistema += ahora - ucp->marca_cuenta;
+	else
+		proc->ns_usuario += ahora - ucp->marca_cuenta;
+	ucp->marca_cuenta = ahora;
+}
+
+/*
+ * Cede la UCP del proceso actual al que elija el planificador. Cada
+ * proceso recupera al volver el modo en que se le quito la UCP; uno
+ * nuevo empieza en modo usuario. Con varias UCP el proceso puede volver
+ * en otra, por lo que la UCP actual no se guarda de antes del cambio.
+ */
+static void cambiar_proceso(){
+	BCP *p_proc_anterior = p_proc_actual, *proceso;
+	int en_sistema = UCP_ACTUAL->cuenta_en_sistema;
+
+	cargar_tiempo(p_proc_anterior);
+	proceso = planificador();
+	p_proc_actual = proceso;
+	trazar(EV_CAMBIO, p_proc_anterior->id, proceso->id);
+	iniciar_cuenta();
+	cambio_contexto(&(p_proc_anterior->contexto_regs), &(proceso->contexto_regs));
+	UCP_ACTUAL->cuenta_en_sistema = en_sistema;
+}
+
+/*
+ *
+ * Funciones que manejan las colas de espera de procesos bloqueados
+ *	bloquear despertar despertar_primero
+ *
+ * Cada motivo de bloqueo tiene su propia cola (terminal, cada ranura de
+ * la rueda de temporizadores, cada mutex), de modo que despertar a un
+ * proceso no requiere recorrer procesos bloqueados por otros motivos.
+ *
+ */
+
+/*
+ * Bloquea al proceso actual en la cola de espera y cede la UCP.
+ */
+static void bloquear(lista_BCPs *cola){
+	int lvl_interrupciones;
+
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	p_proc_actual->estado = BLOQUEADO;
+	clase_de(p_proc_actual)->eliminar(p_proc_actual);
+	insertar_ultimo(cola, p_proc_actual);
+	p_proc_actual->cola_espera = cola;
+	fijar_nivel_int(lvl_interrupciones);
+
+	cambiar_proceso();
+}
+
+static void quitar_temporizador(BCP * proc);
+
+/*
+ * Saca un proceso determinado de su cola de espera y lo pone listo en
+ * su UCP. Si tenia un plazo pendiente se anula. Con EXPULSION_DESPERTAR,
+ * si su clase lo prefiere al proceso en ejecucion en esa UCP, este es
+ * expulsado (los de tiempo real ya lo hacen al insertarse). Si la UCP
+ * espera sin listos, se la despierta.
+ */
+static void despertar(lista_BCPs *cola, BCP * proc){
+	UCP *ucp=UCP_DE(proc);
+	int lvl_interrupciones;
+
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	eliminar_elem(cola, proc);
+	if (proc->tick_despertar)
+		quitar_temporizador(proc);
+	proc->estado = LISTO;
+	trazar(EV_DESPERTAR, proc->id, 0);
+	clase_de(proc)->despertar(proc);
+	clase_de(proc)->insertar(proc);
+	if (EXPULSION_DESPERTAR && ucp->actual && ucp->actual!=proc &&
+	    ucp->actual->estado==LISTO && !proc->tiempo_real &&
+	    !ucp->actual->tiempo_real &&
+	    clase_actual->expulsa(proc, ucp->actual))
+		expulsar_actual(ucp);
+	else if (ucp->inactiva && ucp!=UCP_ACTUAL)
+		activar_IPI(proc->ucp);
+	fijar_nivel_int(lvl_interrupciones);
+}
+
+/*
+ * Despierta al primer proceso de la cola de espera. Devuelve el proceso
+ * desbloqueado o NULL si no habia ninguno.
+ */
+static BCP * despertar_primero(lista_BCPs *cola){
+	BCP *proc = cola->primero;
+
+	if (proc)
+		despertar(cola, proc);
+	return proc;
+}
+
+/*
+ *
+ * Funciones relacionadas con la rueda de temporizadores
+ *	poner_temporizador quitar_temporizador vencer_ranura
+ *
+ * Un proceso con plazo esta en la ranura de su tick de despertar y,
+ * ademas, bloqueado en alguna cola de espera. Al vencer el plazo se le
+ * despierta de esa cola; si lo despierta antes otro evento, despertar
+ * lo saca de la rueda.
+ *
+ */
+
+/*
+ * Programa el despertar del proceso actual en el tick absoluto indicado.
+ * Debe llamarse con las interrupciones de reloj inhibidas y justo antes
+ * de bloquear al proceso.
+ */
+static void poner_temporizador(int tick){
+	lista_BCPs *ranura=&rueda_temporizadores[tick & (TAM_RUEDA-1)];
+	BCP *proc=p_proc_actual;
+
+	proc->tick_despertar=tick;
+	if ((num_temporizadores++==0) || (plazo_minimo && tick<plazo_minimo))
+		plazo_minimo=tick;
+	if (ranura->primero==NULL)
+		ranura->primero=proc;
+	else
+		ranura->ultimo->sig_rueda=proc;
+	proc->ant_rueda=ranura->ultimo;
+	ranura->ultimo=proc;
+	proc->sig_rueda=NULL;
+}
+
+/*
+ * Anula el plazo pendiente de un proceso sacandolo de su ranura.
+ */
+static void quitar_temporizador(BCP * proc){
+	lista_BCPs *ranura=
+		&rueda_temporizadores[proc->tick_despertar & (TAM_RUEDA-1)];
+
+	if (proc->ant_rueda)
+		proc->ant_rueda->sig_rueda=proc->sig_rueda;
+	else
+		ranura->primero=proc->sig_rueda;
+
+	if (proc->sig_rueda)
+		proc->sig_rueda->ant_rueda=proc->ant_rueda;
+	else
+		ranura->ultimo=proc->ant_rueda;
+
+	/* si era el mas proximo se buscara el siguiente cuando haga falta */
+	if ((--num_temporizadores==0) || (proc->tick_despertar==plazo_minimo))
+		plazo_minimo=0;
+	proc->tick_despertar=0;
+}
+
+/*
+ * Despierta los procesos de la ranura del tick actual cuyo plazo ha
+ * vencido. Los que deben esperar otra vuelta de la rueda se quedan.
+ * Solo se recorre la ranura del tick actual.
+ */
+static void vencer_ranura(){
+	lista_BCPs *ranura=&rueda_temporizadores[numTicks & (TAM_RUEDA-1)];
+	BCP *paux, *psig;
+
+	for (paux=ranura->primero; paux; paux=psig) {
+		psig=paux->sig_rueda;
+		if (paux->tick_despertar<=numTicks)
+			despertar(paux->cola_espera, paux);
+	}
+}
+
+/*
+ *
+ * Funciones del reloj dinamico
+ *	proximo_temporizador parar_reloj reanudar_reloj
+ *
+ * Sin procesos listos no hay trabajo periodico que hacer, salvo vencer
+ * los plazos de la rueda. En lugar de una interrupcion por tick se
+ * programa una sola para el tick del plazo mas proximo y, al despertar
+ * por ella o por otra interrupcion, numTicks avanza de golpe los ticks
+ * transcurridos. El reloj se reprograma con programar_reloj del HAL.
+ *
+ */
+
+/*
+ * Tick del plazo mas proximo de la rueda de temporizadores (0 si no hay).
+ * Normalmente es plazo_minimo; si se ha quitado el que lo era, se busca
+ * recorriendo las ranuras a partir del tick siguiente al actual hasta
+ * la primera con un plazo de esta vuelta de la rueda, que es el mas
+ * proximo porque todos los plazos son posteriores a numTicks.
+ */
+static int proximo_temporizador(){
+	int tick, proximo=0;
+	BCP *paux;
+
+	if (num_temporizadores==0 || plazo_minimo)
+		return plazo_minimo;
+
+	for (tick=numTicks+1; tick<=numTicks+TAM_RUEDA; tick++) {
+		for (paux=rueda_temporizadores[tick & (TAM_RUEDA-1)].primero;
+		     paux; paux=paux->sig_rueda)
+			if (proximo==0 || paux->tick_despertar < proximo)
+				proximo=paux->tick_despertar;
+		if (proximo && proximo<=tick)
+			break;
+	}
+	plazo_minimo=proximo;
+	return proximo;
+}
+
+/*
+ * Suprime las interrupciones de reloj hasta el tick del plazo mas
+ * proximo (como mucho MAX_TICKS_PARADO). Se invoca con las
+ * interrupciones inhibidas. Devuelve 1 si ha parado el reloj.
+ */
+static int parar_reloj(){
+	int proximo, ticks;
+
+	proximo=proximo_temporizador();
+	ticks = proximo ? proximo - numTicks : MAX_TICKS_PARADO;
+	if (ticks > MAX_TICKS_PARADO)
+		ticks = MAX_TICKS_PARADO;
+	if (ticks <= 1)
+		return 0;
+
+	/* conserva la fase: la interrupcion llega cuando llegaria la del
+	   tick ticks-esimo */
+	programar_reloj(consultar_reloj() + (long)(ticks - 1) * USEG_TICK);
+	ticks_parado = ticks;
+	return 1;
+}
+
+static void int_reloj();
+
+/*
+ * Tiempo virtual: si ningun proceso espera al terminal, nada puede
+ * despertar a nadie antes del plazo mas proximo, asi que numTicks salta
+ * hasta el tick anterior y se trata la interrupcion de reloj de ese
+ * plazo como si hubiera llegado. Se invoca con las interrupciones
+ * inhibidas. Devuelve 0 si no se puede adelantar.
+ */
+static int adelantar_reloj(){
+	int proximo;
+
+	if (lista_espera_terminal.primero)
+		return 0;
+	proximo=proximo_temporizador();
+	if (proximo==0)
+		return 0;
+
+	if (proximo - 1 > numTicks) {
+		ticks_adelantados += proximo - 1 - numTicks;
+		numTicks = proximo - 1;
+	}
+	int_reloj();
+	return 1;
+}
+
+/*
+ * Si el reloj estaba parado, suma a numTicks los ticks transcurridos
+ * (sin contar el de la interrupcion de reloj en curso, si es esa) y
+ * vuelve a programar una interrupcion por tick en la fase original. La
+ * invocan al comenzar los manejadores de interrupcion.
+ */
+static void reanudar_reloj(){
+	long resto;
+	int pendientes;
+
+	if (!ticks_parado)
+		return;
+
+	resto = consultar_reloj();
+	pendientes = (resto + USEG_TICK - 1) / USEG_TICK;
+	if (pendientes < 1)
+		pendientes = 1;
+	if (pendientes > ticks_parado)
+		pendientes = ticks_parado;
+
+	numTicks += ticks_parado - pendientes;
+	ticks_saltados += ticks_parado - pendientes;
+	programar_reloj(resto - (long)(pendientes - 1) * USEG_TICK);
+	ticks_parado = 0;
+}
+
+/*
+ *
+ * Funciones auxiliares de los mutex
+ *	iniciar_mutex buscar_mutex leer_nombre_mutex obtener_mutex
+ *	soltar_mutex cerrar_descriptor cerrar_mutex_proceso
+ *
+ * Los mutex existentes estan en una tabla hash por nombre y los libres
+ * en una lista; cada proceso los referencia mediante su tabla de
+ * descriptores. Al desbloquear un mutex con procesos esperando, la
+ * propiedad pasa directamente al primero de la cola, de modo que ningun
+ * otro proceso puede adelantarle.
+ *
+ */
+
+/*
+ * Inicia la lista de mutex libres y la tabla hash vacia.
+ */
+static void iniciar_mutex(){
+	int i;
+
+	for (i=0; i<TAM_HASH_MUT; i++)
+		hash_mutex[i]=NULL;
+	for (i=NUM_MUT-1; i>=0; i--) {
+		array_mutex[i].nombre[0]='\0';
+		array_mutex[i].sig_hash=mutex_libres;
+		mutex_libres=&array_mutex[i];
+	}
+}
+
+/*
+ * Cubeta de la tabla hash que corresponde a un nombre.
+ */
+static mutex ** cubeta_mutex(char *nombre){
+	unsigned int h=5381;
+
+	while (*nombre)
+		h=h*33 + (unsigned char)*nombre++;
+	return &hash_mutex[h & (TAM_HASH_MUT-1)];
+}
+
+/*
+ * Busca un mutex existente por nombre. Devuelve NULL si no existe.
+ */
+static mutex * buscar_mutex(char *nombre){
+	mutex *m;
+
+	for (m=*cubeta_mutex(nombre); m; m=m->sig_hash)
+		if (strcmp(m->nombre, nombre)==0)
+			return m;
+	return NULL;
+}
+
+/*
+ * Copia el nombre de un mutex desde el espacio de usuario. Devuelve -1
+ * si es mas largo de MAX_NOM_MUT caracteres.
+ */
+static int leer_nombre_mutex(char *nombre_usr, char *nombre){
+	int i;
+
+	accesoParam = 1;
+	for (i=0; i<=MAX_NOM_MUT; i++)
+		if ((nombre[i]=nombre_usr[i])=='\0')
+			break;
+	accesoParam = 0;
+	return (i>MAX_NOM_MUT) ? -1 : 0;
+}
+
+/*
+ * Devuelve el mutex asociado a un descriptor del proceso actual, o NULL
+ * si el descriptor no es valido.
+ */
+static mutex * obtener_mutex(unsigned int desc){
+	if (desc>=NUM_MUT_PROC)
+		return NULL;
+	return p_proc_actual->descriptores[desc];
+}
+
+/*
+ * Dice si el proceso actual es el propietario de un mutex.
+ */
+static int es_propietario(mutex *m){
+	return (m->compartida.palabra & ~ESPERAS_MUTEX)==MARCA_MUTEX(p_proc_actual);
+}
+
+/*
+ * Proceso que tiene un mutex, o NULL si esta libre.
+ */
+static BCP * propietario_mutex(mutex *m){
+	unsigned int marca=m->compartida.palabra & ~ESPERAS_MUTEX;
+
+	return marca ? buscar_BCP(marca-1) : NULL;
+}
+
+/*
+ * Prioridad que hereda un proceso: la efectiva mas prioritaria de los
+ * procesos de su clase que esperan en los mutex que tiene.
+ */
+static int calcular_herencia(BCP *proc){
+	clase_planificacion *clase=clase_de(proc);
+	int i, prioridad=SIN_HERENCIA;
+	mutex *m;
+	BCP *paux;
+
+	for (i=0; i<NUM_MUT_PROC; i++) {
+		m=proc->descriptores[i];
+		if ((m==NULL) || ((m->compartida.palabra & ~ESPERAS_MUTEX)!=
+				MARCA_MUTEX(proc)))
+			continue;
+		for (paux=m->bloqueados.primero; paux; paux=paux->siguiente)
+			if ((clase_de(paux)==clase) &&
+			    (clase->prioridad(paux)<prioridad))
+				prioridad=clase->prioridad(paux);
+	}
+	return prioridad;
 }
 
 /*
- * Funcin que busca una entrada libre en la tabla de procesos
+ * Cambia la prioridad heredada de un proceso. Si esta listo se saca y
+ * se vuelve a insertar en la estructura de listos de su clase, para
+ * que se coloque segun su nueva prioridad efectiva.
  */
-static int buscar_BCP_libre(){
-	int i;
+static void fijar_herencia(BCP *proc, int prioridad){
+	int lvl_interrupciones;
 
-	for (i=0; i<MAX_PROC; i++)
-		if (tabla_procs[i].estado==NO_USADA)
-			return i;
-	return -1;
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	if (proc->estado==LISTO) {
+		clase_de(proc)->eliminar(proc);
+		proc->prioridad_heredada=prioridad;
+		clase_de(proc)->insertar(proc);
+	}
+	else
+		proc->prioridad_heredada=prioridad;
+	fijar_nivel_int(lvl_interrupciones);
 }
 
 /*
- *
- * Funciones que facilitan el manejo de las listas de BCPs
- *	insertar_ultimo eliminar_primero eliminar_elem
- *
- * NOTA: PRIMERO SE DEBE LLAMAR A eliminar Y LUEGO A insertar
+ * Siguiente proceso de una cadena de herencia: el propietario del mutex
+ * que espera un proceso, o NULL si no espera ninguno.
  */
+static BCP * siguiente_herencia(BCP *proc){
+	return proc->esperando_mutex ?
+		propietario_mutex(proc->esperando_mutex) : NULL;
+}
 
 /*
- * Inserta un BCP al final de la lista.
+ * El proceso donante va a esperar el mutex de proc: proc, y los
+ * propietarios de los mutex que espera a su vez, heredan su prioridad
+ * efectiva si es mas prioritaria que la que tenian. La cadena se corta
+ * en el primer proceso de otra clase.
  */
-static void insertar_ultimo(lista_BCPs *lista, BCP * proc){
-	if (lista->primero==NULL)
-		lista->primero= proc;
-	else
-		lista->ultimo->siguiente=proc;
-	lista->ultimo= proc;
-	proc->siguiente=NULL;
+static void heredar_prioridad(BCP *proc, BCP *donante){
+	clase_planificacion *clase=clase_de(donante);
+	int prioridad;
+
+	if (!HERENCIA_PRIORIDAD || (clase->prioridad==NULL))
+		return;
+
+	prioridad=clase->prioridad(donante);
+	for (; proc && (clase_de(proc)==clase) &&
+	     (prioridad<clase->prioridad(proc)); proc=siguiente_herencia(proc))
+		fijar_herencia(proc, prioridad);
 }
 
 /*
- * Elimina el primer BCP de la lista.
+ * Recalcula la prioridad heredada de un proceso cuyos mutex han cambiado
+ * y, si cambia, la propaga por la cadena de propietarios.
  */
-static void eliminar_primero(lista_BCPs *lista){
+static void propagar_herencia(BCP *proc){
+	int prioridad;
 
-	if (lista->ultimo==lista->primero)
-		lista->ultimo=NULL;
-	lista->primero=lista->primero->siguiente;
+	if (!HERENCIA_PRIORIDAD)
+		return;
+
+	for (; proc && clase_de(proc)->prioridad; proc=siguiente_herencia(proc)) {
+		prioridad=calcular_herencia(proc);
+		if (prioridad==proc->prioridad_heredada)
+			break;
+		fijar_herencia(proc, prioridad);
+	}
 }
 
 /*
- * Elimina un determinado BCP de la lista.
+ * Libera del todo un mutex que tiene el proceso actual: si hay
+ * procesos esperando se le entrega al primero, que pasa a listo. Tanto
+ * el proceso actual como el nuevo propietario recalculan su herencia.
  */
-static void eliminar_elem(lista_BCPs *lista, BCP * proc){
-	BCP *paux=lista->primero;
+static void soltar_mutex(mutex *m){
+	BCP *sig=m->bloqueados.primero;
 
-	if (paux==proc)
-		eliminar_primero(lista);
-	else {
-		for ( ; ((paux) && (paux->siguiente!=proc));
-			paux=paux->siguiente);
-		if (paux) {
-			if (lista->ultimo==paux->siguiente)
-				lista->ultimo=paux;
-			paux->siguiente=paux->siguiente->siguiente;
-		}
+	m->compartida.num_bloqueos=0;
+	if (sig==NULL) {
+		m->compartida.palabra=0;
+		return;
 	}
+	despertar(&m->bloqueados, sig);
+	sig->esperando_mutex=NULL;
+	m->compartida.num_bloqueos=1;
+	m->compartida.palabra=MARCA_MUTEX(sig) |
+		(m->bloqueados.primero ? ESPERAS_MUTEX : 0);
+
+	propagar_herencia(sig);
+	propagar_herencia(p_proc_actual);
 }
 
 /*
- *
- * Funciones relacionadas con la planificacion
- *	espera_int planificador
+ * Cierra un descriptor del proceso actual. Si el proceso tenia el mutex
+ * bloqueado lo suelta, y si era la ultima referencia lo elimina,
+ * despertando a un proceso que espere para crear un mutex.
  */
+static void cerrar_descriptor(unsigned int desc){
+	mutex *m=p_proc_actual->descriptores[desc], **pm;
 
-/*
- * Espera a que se produzca una interrupcion
- */
-static void espera_int(){
-	int nivel;
+	p_proc_actual->descriptores[desc]=NULL;
+	if (es_propietario(m))
+		soltar_mutex(m);
+	if (--m->abiertos>0)
+		return;
 
-	/*printk("-> NO HAY LISTOS. ESPERA INT\n");*/
-	/* Baja al mnimo el nivel de interrupcin mientras espera */
-	nivel=fijar_nivel_int(NIVEL_1);
-	halt();
-	fijar_nivel_int(nivel);
+	/* eliminacion: fuera de la tabla hash y a la lista de libres */
+	for (pm=cubeta_mutex(m->nombre); *pm!=m; pm=&(*pm)->sig_hash)
+		;
+	*pm=m->sig_hash;
+	m->nombre[0]='\0';
+	m->sig_hash=mutex_libres;
+	mutex_libres=m;
+	mutexExistentes--;
+
+	/* nadie puede estar esperando en el: todos lo tendrian abierto */
+	despertar_primero(&lista_espera_mutex);
 }
 
 /*
- * Funcin de planificacion que implementa un algoritmo FIFO.
+ * Cierre implicito de los mutex que tiene abiertos el proceso actual.
  */
-static BCP * planificador(){
-	while (lista_listos.primero==NULL)
-		espera_int();		/* No hay nada que hacer */
-
-	/*Aqui asignaremos la rodaja del proceso*/
-	BCP *proceso = lista_listos.primero;
-	proceso->ticksRestantes = TICKS_POR_RODAJA;
-
-
+static void cerrar_mutex_proceso(){
+	int i;
 
-	return lista_listos.primero;
+	for (i=0; i<NUM_MUT_PROC; i++)
+		if (p_proc_actual->descriptores[i])
+			cerrar_descriptor(i);
 }
 
 /*
@@ -135,25 +1665,39 @@ static BCP * planificador(){
  *
  */
 static void liberar_proceso(){
-	BCP * p_proc_anterior;
+	BCP * p_proc_anterior, *proceso;
 
-	liberar_imagen(p_proc_actual->info_mem); /* liberar mapa */
+	cerrar_mutex_proceso(); /* cierre implicito de mutex */
+	if (p_proc_actual->tiempo_real)
+		terminar_tiempo_real(p_proc_actual);
+
+	/* al liberar la ultima imagen el sistema se para */
+	if (--num_procesos==0)
+		mostrar_estadisticas();
+
+	devolver_imagen(p_proc_actual); /* liberar mapa */
+	if (num_procesos==0)
+		vaciar_cache_imagenes();
 
 	p_proc_actual->estado=TERMINADO;
 
 	int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-	eliminar_primero(&lista_listos); /* proc. fuera de listos */
+	clase_de(p_proc_actual)->eliminar(p_proc_actual); /* proc. fuera de listos */
 	fijar_nivel_int(lvl_interrupciones);
 
 	/* Realizar cambio de contexto */
 	p_proc_anterior=p_proc_actual;
-	p_proc_actual=planificador();
+	proceso=planificador();
+	p_proc_actual=proceso;
 
 	printk("-> C.CONTEXTO POR FIN: de %d a %d\n",
-			p_proc_anterior->id, p_proc_actual->id);
+			p_proc_anterior->id, proceso->id);
 
-	liberar_pila(p_proc_anterior->pila);
-	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
+	trazar(EV_CAMBIO, p_proc_anterior->id, proceso->id);
+	devolver_pila(p_proc_anterior->pila);
+	liberar_BCP(p_proc_anterior);
+	iniciar_cuenta();
+	cambio_contexto(NULL, &(proceso->contexto_regs));
         return; /* no debera llegar aqui */
 }
 
@@ -206,49 +1750,29 @@ if(accesoParam == 0){
 static void int_terminal(){
 	char car;
 
+	reanudar_reloj();
 	car = leer_puerto(DIR_TERMINAL);
+	trazar(EV_INT_TERMINAL, p_proc_actual ? p_proc_actual->id : -1, car);
 	printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
 
-	// si el buffer no est lleno introduce el caracter nuevo
-	if(caracteresEnBuffer >= TAM_BUF_TERM){
+	// si el buffer est lleno se descarta el caracter
+	if(caracteresEnBuffer() >= TAM_BUF_TERM){
+		if (!buffer_desbordado)
+			desbordamientos_term++;
+		buffer_desbordado=1;
+		caracteres_perdidos++;
+		trazar(EV_PERDIDO, -1, car);
 		return;
 	}
+	buffer_desbordado=0;
 
-	if(caracteresEnBuffer < TAM_BUF_TERM){
-		bufferCaracteres[caracteresEnBuffer] = car;
-		caracteresEnBuffer++;		
+	// primero el dato y luego el indice, que lo publica al lector
+	bufferCaracteres[finBuffer & MASCARA_BUF_TERM] = car;
+	tickCaracteres[finBuffer & MASCARA_BUF_TERM] = numTicks;
+	finBuffer++;
 
-		// desbloquea primer proceso bloqueado por lectura
-		BCP *proceso_bloqueado = lista_bloqueados.primero;
-	
-		int desbloqueado = 0;
-		if (proceso_bloqueado != NULL){
-			if(proceso_bloqueado->bloqueo_por_lectura == 1){
-				// Desbloquear proceso
-				desbloqueado = 1;
-				proceso_bloqueado->estado = LISTO;
-				proceso_bloqueado->bloqueo_por_lectura = 0;
-				int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-				eliminar_elem(&lista_bloqueados, proceso_bloqueado);
-				insertar_ultimo(&lista_listos, proceso_bloqueado);
-				fijar_nivel_int(lvl_interrupciones);
-			}
-		}
-		
-		while(desbloqueado != 1 && proceso_bloqueado != lista_bloqueados.ultimo){
-			proceso_bloqueado = proceso_bloqueado->siguiente;
-			if(proceso_bloqueado->bloqueo_por_lectura == 1){
-				// Desbloquear proceso
-				desbloqueado = 1;
-				proceso_bloqueado->estado = LISTO;
-				proceso_bloqueado->bloqueo_por_lectura = 0;
-				int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-				eliminar_elem(&lista_bloqueados, proceso_bloqueado);
-				insertar_ultimo(&lista_listos, proceso_bloqueado);
-				fijar_nivel_int(lvl_interrupciones);
-			}
-		}
-	}
+	// desbloquea al primer proceso que espera en el terminal
+	despertar_primero(&lista_espera_terminal);
 
         return;
 }
@@ -260,67 +1784,71 @@ static void int_reloj(){
 
 	//printk("-> TRATANDO INT. DE RELOJ\n");
 
+	/* con el reloj parado se ponen al dia los ticks suprimidos */
+	reanudar_reloj();
+	trazar(EV_INT_RELOJ, p_proc_actual ? p_proc_actual->id : -1, numTicks);
 
-	BCP *proceso_listo = lista_listos.primero;
-	
-	/* PARTE TIEMPOS_PROCESO Aadimos contadores usuario o a sistema para el proceso en ejecucin. Si es nulo nada.*/
-	if(proceso_listo != NULL){
+	/* PARTE TIEMPOS_PROCESO Aadimos contadores usuario o a sistema para el proceso en ejecucin. Si no hay listos nada.*/
+	if(p_proc_actual && p_proc_actual->estado==LISTO){
 		if(viene_de_modo_usuario()){
 			p_proc_actual->contador_usuario++;
 		}
 		else{
 			p_proc_actual->contador_sistema++;
 		}
-	
 
-		/* Comprobamos la rodaja de tiempo */
-		if(p_proc_actual->ticksRestantes <= 1){
+		/* Comprobamos la rodaja de tiempo con la clase de planificacion */
+		if(clase_de(p_proc_actual)->tick(p_proc_actual)){
 			/*Si ha consumido toda la rodaja activamos un intr de software*/
-			id_int_soft = p_proc_actual->id;
+			UCP_ACTUAL->id_int_soft = p_proc_actual->id;
+			UCP_ACTUAL->expulsion_pendiente = 0;
 			activar_int_SW();
 		}
-		else{
-			/*Restamos rodaja*/
-			p_proc_actual->ticksRestantes--;
-		}
 	}
 
+	/* el tiempo del sistema lo lleva el reloj de la UCP 0 */
+	if (ID_UCP_ACTUAL != 0)
+		return;
 
 	numTicks++;
 
-	BCP *proceso_desbloqueo = lista_bloqueados.primero;
-	BCP *proceso_siguiente = NULL;
-	if(proceso_desbloqueo != NULL){
-		proceso_siguiente = proceso_desbloqueo->siguiente;
-	}
-
-	/*Despierta proceso dormido*/
-	while(proceso_desbloqueo != NULL){
-		
-		/*Calculamos el tiempo de bloqueo*/
-		int numTicksBloqueo = proceso_desbloqueo->segundos_bloqueo * TICK;
-		int ticksTranscurridos = numTicks - proceso_desbloqueo->tiempo_inicio_bloq;
+	/*Despierta los procesos dormidos de la ranura de este tick*/
+	vencer_ranura();
 
-		/* Debe desbloquearse el proceso? */
-		if(ticksTranscurridos >= numTicksBloqueo && 
-				proceso_desbloqueo->bloqueo_por_lectura == 0 ){
+    return;
+}
 
-			/*Proceso pasa a listo*/
-			proceso_desbloqueo->estado = LISTO;
+/*
+ * Cubeta del histograma de latencias que corresponde a un tiempo.
+ */
+static int cubeta_latencia(long long ns){
+	int i;
 
-			int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-			eliminar_elem(&lista_bloqueados, proceso_desbloqueo);
-			insertar_ultimo(&lista_listos, proceso_desbloqueo);
-			fijar_nivel_int(lvl_interrupciones);	
-		}
+	if (ns<=1)
+		return 0;
+	i = 63 - __builtin_clzll(ns);
+	return (i<NUM_CUBETAS_LAT) ? i : NUM_CUBETAS_LAT - 1;
+}
 
-		proceso_desbloqueo = proceso_siguiente;
-		if(proceso_desbloqueo != NULL){
-			proceso_siguiente = proceso_desbloqueo->siguiente;
-		}
+/*
+ * Anota una invocacion de una llamada que ha durado total nanosegundos,
+ * de los que cpu ha pasado el proceso en la UCP.
+ */
+static void anotar_latencia(struct latencias_llamsis *lat, long long cpu,
+				long long total){
+	long long bloqueado = total - cpu;
+
+	lat->llamadas++;
+	lat->cpu[cubeta_latencia(cpu)]++;
+	if (cpu > lat->max_cpu)
+		lat->max_cpu = cpu;
+	/* sin cambio de contexto todo el tiempo se carga como de UCP */
+	if (bloqueado > 0) {
+		lat->bloqueos++;
+		lat->bloqueado[cubeta_latencia(bloqueado)]++;
+		if (bloqueado > lat->max_bloqueado)
+			lat->max_bloqueado = bloqueado;
 	}
-
-    return;
 }
 
 /*
@@ -328,13 +1856,29 @@ static void int_reloj(){
  */
 static void tratar_llamsis(){
 	int nserv, res;
+	long long inicio, cpu_inicio;
+
+	/* hasta aqui el proceso estaba en modo usuario */
+	cargar_tiempo(p_proc_actual);
+	UCP_ACTUAL->cuenta_en_sistema = 1;
+	inicio = UCP_ACTUAL->marca_cuenta;
+	cpu_inicio = p_proc_actual->ns_sistema;
 
 	nserv=leer_registro(0);
+	trazar(EV_LLAMSIS, p_proc_actual->id, nserv);
 	if (nserv<NSERVICIOS)
 		res=(tabla_servicios[nserv].fservicio)();
 	else
 		res=-1;		/* servicio no existente */
 	escribir_registro(0,res);
+	trazar(EV_FIN_LLAMSIS, p_proc_actual->id, res);
+
+	cargar_tiempo(p_proc_actual);
+	UCP_ACTUAL->cuenta_en_sistema = 0;
+	if (nserv>=0 && nserv<NSERVICIOS)
+		anotar_latencia(&latencias[nserv],
+			p_proc_actual->ns_sistema - cpu_inicio,
+			UCP_ACTUAL->marca_cuenta - inicio);
 	return;
 }
 
@@ -342,27 +1886,106 @@ static void tratar_llamsis(){
  * Tratamiento de interrupciones software
  */
 static void int_sw(){
+	UCP *ucp=UCP_ACTUAL;
 
 	//printk("-> TRATANDO INT. SW\n");
-
-	/*Queremos bloquear el proceso actual*/
-	if(id_int_soft == p_proc_actual->id){
-		/*Proceso actual al final de la cola de listos*/
-		BCP *proceso = lista_listos.primero;
+	if (p_proc_actual==NULL)
+		return;		/* UCP que aun no ha ejecutado ningun proceso */
+	trazar(EV_INT_SW, p_proc_actual->id, ucp->id_int_soft);
+
+	/*Queremos bloquear el proceso actual (con varias UCP puede haberse
+	  bloqueado entre la peticion y la interrupcion)*/
+	if(ucp->id_int_soft == p_proc_actual->id &&
+	   p_proc_actual->estado == LISTO){
+		/*Su clase reencola al proceso actual; si lo expulsa otro que
+		  pasa a listo, se reencola sin tratarlo como fin de rodaja*/
 		int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-		eliminar_elem(&lista_listos, proceso);
-		insertar_ultimo(&lista_listos, proceso);
+		if (ucp->expulsion_pendiente) {
+			ucp->expulsion_pendiente = 0;
+			clase_de(p_proc_actual)->eliminar(p_proc_actual);
+			clase_de(p_proc_actual)->insertar(p_proc_actual);
+		}
+		else
+			clase_de(p_proc_actual)->ceder(p_proc_actual);
 		fijar_nivel_int(lvl_interrupciones);
 
 		// Cambio de contexto por int sw de planificacin
-		BCP *p_proc_bloqueado = p_proc_actual;
-		p_proc_actual = planificador();
-		cambio_contexto(&(p_proc_bloqueado->contexto_regs), &(p_proc_actual->contexto_regs));
+		cambiar_proceso();
 	}
 
 	return;
 }
 
+/*
+ *
+ * Funciones del multiprocesador
+ *	int_ipi arrancar_ucp arranque_proceso
+ *
+ */
+
+#if NUM_UCPS > 1
+/*
+ * Tratamiento de interrupciones entre UCP: otra UCP ha dejado listo un
+ * proceso en esta. Si debe expulsar al actual se activa la interrupcion
+ * software; si no, basta con haber sacado a la UCP de la espera.
+ */
+static void int_ipi(){
+	UCP *ucp=UCP_ACTUAL;
+
+	if (ucp->int_sw_pedida) {
+		ucp->int_sw_pedida = 0;
+		activar_int_SW();
+	}
+}
+
+/*
+ * Primera funcion que ejecutan las UCP distintas de la 0, al nivel 3:
+ * esperan a tener un proceso listo, en general robado a otra UCP, y lo
+ * ponen en ejecucion.
+ */
+static void arrancar_ucp(){
+	BCP *proceso;
+
+	tomar_nucleo();
+	proceso=planificador();
+	p_proc_actual=proceso;
+	trazar(EV_CAMBIO, -1, proceso->id);
+	iniciar_cuenta();
+	cambio_contexto(NULL, &(proceso->contexto_regs));
+	panico("UCP reactivada inesperadamente");
+}
+
+/*
+ * La ejecuta cada proceso nuevo antes de pasar a modo usuario: la UCP que
+ * pasa por primera vez a un proceso tiene el cerrojo del nucleo, y no hay
+ * un manejador al que volver que lo suelte.
+ */
+static void arranque_proceso(){
+	soltar_nucleo();
+}
+
+/*
+ * Manejadores que se instalan: el tratamiento con el cerrojo tomado
+ */
+#define DEFINIR_MANEJADOR(rutina) \
+static void rutina##_ucp(){ \
+	int tomado=tomar_nucleo(); \
+	rutina(); \
+	if (tomado) \
+		soltar_nucleo(); \
+}
+DEFINIR_MANEJADOR(exc_arit)
+DEFINIR_MANEJADOR(exc_mem)
+DEFINIR_MANEJADOR(int_reloj)
+DEFINIR_MANEJADOR(int_terminal)
+DEFINIR_MANEJADOR(tratar_llamsis)
+DEFINIR_MANEJADOR(int_sw)
+DEFINIR_MANEJADOR(int_ipi)
+#define MANEJADOR(rutina) rutina##_ucp
+#else
+#define MANEJADOR(rutina) rutina
+#endif
+
 /*
  *
  * Funcion auxiliar que crea un proceso reservando sus recursos.
@@ -371,37 +1994,56 @@ static void int_sw(){
  */
 static int crear_tarea(char *prog){
 	void * imagen, *pc_inicial;
-	int error=0;
-	int proc;
+	int error=0, i;
 	BCP *p_proc;
 
-	proc=buscar_BCP_libre();
-	if (proc==-1)
+	p_proc=buscar_BCP_libre();
+	if (p_proc==NULL)
 		return -1;	/* no hay entrada libre */
 
 	/* rellenamos el BCP*/
-	p_proc=&(tabla_procs[proc]);
 
 	/* crea la imagen de memoria leyendo ejecutable */
-	imagen=crear_imagen(prog, &pc_inicial);
+	imagen=obtener_imagen(prog, &pc_inicial, p_proc);
 	if (imagen)
 	{
 		p_proc->info_mem=imagen;
-		p_proc->pila=crear_pila(TAM_PILA);
-		fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
-			pc_inicial,
+		p_proc->pila=obtener_pila();
+		/* el area de usuario queda por debajo de la pila */
+		memset(p_proc->pila, 0, TAM_AREA_USUARIO);
+		fijar_contexto_ini(p_proc->info_mem,
+			(char *)p_proc->pila + TAM_AREA_USUARIO,
+			TAM_PILA - TAM_AREA_USUARIO, pc_inicial,
 			&(p_proc->contexto_regs));
-		p_proc->id=proc;
 		p_proc->estado=LISTO;
-
-		/* lo inserta al final de cola de listos */
+		p_proc->nivel=0;
+		p_proc->prioridad_heredada=SIN_HERENCIA;
+		p_proc->nice=0;
+		p_proc->tiempo_real=0;
+		p_proc->ucp=ID_UCP_ACTUAL;
+		p_proc->vtiempo=UCP_ACTUAL->vtiempo_minimo;
+		p_proc->ticks_pendientes=0;
+		p_proc->esperando_mutex=NULL;
+		p_proc->contador_usuario=0;
+		p_proc->contador_sistema=0;
+		p_proc->ns_usuario=0;
+		p_proc->ns_sistema=0;
+		p_proc->tick_despertar=0;
+		p_proc->anillo=NULL;
+		for (i=0; i<NUM_MUT_PROC; i++)
+			p_proc->descriptores[i]=NULL;
+		num_procesos++;
+
+		/* lo inserta en la estructura de listos de la clase actual */
 		int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-		insertar_ultimo(&lista_listos, p_proc);
+		clase_actual->insertar(p_proc);
 		fijar_nivel_int(lvl_interrupciones);
 		error= 0;
 	}
-	else
+	else {
+		liberar_BCP(p_proc);
 		error= -1; /* fallo al crear imagen */
+	}
 
 	return error;
 }
@@ -478,27 +2120,18 @@ int sis_dormir(){
 	segundos = (unsigned int)leer_registro(1);
 	printk("-> durmiendo \n");
 
-	p_proc_actual->estado = BLOQUEADO;
-	p_proc_actual->tiempo_inicio_bloq = numTicks;
-	p_proc_actual->segundos_bloqueo = segundos;	
-
-	/*Interrupciones inhubidas y guardamos anterior nivel*/
+	/*Se bloquea con un plazo en la rueda de temporizadores*/
 	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-	
-	/*Lo sacamos de listos al proceso*/
-	eliminar_elem(&lista_listos, p_proc_actual);
-
-	/*Lo introducimos en bloqueados*/
-	insertar_ultimo(&lista_bloqueados, p_proc_actual);
-
-	/*Fijamos el anterior nivel de interrupcion*/
+	/* Como minimo espera al siguiente tick */
+	if(segundos == 0){
+		poner_temporizador(numTicks + 1);
+	}
+	else{
+		poner_temporizador(numTicks + segundos * TICK);
+	}
+	bloquear(&lista_dormidos);
 	fijar_nivel_int(lvl_interrupciones);
 
-	/*Realizamos el cambio de contexto */
-	BCP *p_proc_dormido = p_proc_actual;
-	p_proc_actual = planificador();
-	cambio_contexto(&(p_proc_dormido->contexto_regs), &(p_proc_actual->contexto_regs));
-
 	return 0;
 
 
@@ -526,89 +2159,550 @@ int sis_tiempos_proceso(){
 	return numTicks;
 }
 
+/*
+ * Como tiempos_proceso, pero ademas devuelve los tiempos de usuario y de
+ * sistema en nanosegundos, incluyendo lo que lleva esta llamada.
+ */
+int sis_tiempos_proceso_ns(){
+	tiempos_ejec_ns *tiempos;
 
-int sis_crear_mutex(){
+	tiempos = (tiempos_ejec_ns *)leer_registro(1);
+	if (tiempos != NULL) {
+		cargar_tiempo(p_proc_actual);
+		accesoParam = 1;
+		tiempos->usuario = p_proc_actual->contador_usuario;
+		tiempos->sistema = p_proc_actual->contador_sistema;
+		tiempos->usuario_ns = p_proc_actual->ns_usuario;
+		tiempos->sistema_ns = p_proc_actual->ns_sistema;
+		accesoParam = 0;
+	}
+	return numTicks;
+}
+
+/*
+ * Copia al usuario hasta max eventos de la traza aun no leidos, del mas
+ * antiguo al mas reciente, y devuelve cuantos ha copiado. Si se han
+ * sobrescrito eventos sin leer se salta a los que quedan. Devuelve -1
+ * si el nucleo se ha compilado sin traza.
+ */
+int sis_leer_traza(){
+#if TRAZA
+	struct evento_traza *eventos;
+	int max, n=0, lvl_interrupciones;
+
+	eventos = (struct evento_traza *)leer_registro(1);
+	max = (int)leer_registro(2);
+
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	if (eventos_traza - leidos_traza > TAM_TRAZA) {
+		perdidos_traza += eventos_traza - leidos_traza - TAM_TRAZA;
+		leidos_traza = eventos_traza - TAM_TRAZA;
+	}
+	accesoParam = 1;
+	while (n<max && leidos_traza!=eventos_traza)
+		eventos[n++] = traza[leidos_traza++ & (TAM_TRAZA - 1)];
+	accesoParam = 0;
+	fijar_nivel_int(lvl_interrupciones);
+	return n;
+#else
+	return -1;
+#endif
+}
 
+/*
+ * Copia al usuario las estadisticas de latencia de hasta max llamadas,
+ * en el orden de sus numeros. Devuelve el numero de llamadas existentes.
+ */
+int sis_leer_latencias(){
+	struct latencias_llamsis *lat;
+	int max, i;
+
+	lat = (struct latencias_llamsis *)leer_registro(1);
+	max = (int)leer_registro(2);
+
+	accesoParam = 1;
+	for (i=0; i<max && i<NSERVICIOS; i++)
+		lat[i] = latencias[i];
+	accesoParam = 0;
+	return NSERVICIOS;
 }
 
 
-int sis_abrir_mutex(){
+/*
+ * Busca un descriptor libre en el proceso actual. Devuelve -1 si no hay.
+ */
+static int descriptor_libre(){
+	int i;
+
+	for (i=0; i<NUM_MUT_PROC; i++)
+		if (p_proc_actual->descriptores[i]==NULL)
+			return i;
+	return -1;
+}
+
+/*
+ * Crea un mutex y lo abre. Si ya existen NUM_MUT mutex se bloquea hasta
+ * que se elimine alguno. Devuelve el descriptor, o -1 si el nombre es
+ * demasiado largo o ya existe, o si el proceso no tiene descriptores.
+ */
+int sis_crear_mutex(){
+	char nombre[MAX_NOM_MUT+1];
+	int tipo, desc;
+	mutex *m, **cubeta;
+
+	if (leer_nombre_mutex((char *)leer_registro(1), nombre)<0)
+		return -1;
+	tipo = (int)leer_registro(2);
+	if (tipo!=NO_RECURSIVO && tipo!=RECURSIVO)
+		return -1;
+
+	// mientras espera hueco otro puede crear un mutex con el mismo nombre
+	for(;;){
+		if (buscar_mutex(nombre) || (desc=descriptor_libre())<0)
+			return -1;
+		if (mutex_libres)
+			break;
+		bloquear(&lista_espera_mutex);
+	}
 
+	m = mutex_libres;
+	mutex_libres = m->sig_hash;
+	strcpy(m->nombre, nombre);
+	m->compartida.palabra = 0;
+	m->compartida.tipo = tipo;
+	m->compartida.num_bloqueos = 0;
+	m->abiertos = 1;
+	m->bloqueados.primero = m->bloqueados.ultimo = NULL;
+	cubeta = cubeta_mutex(nombre);
+	m->sig_hash = *cubeta;
+	*cubeta = m;
+	mutexExistentes++;
+
+	p_proc_actual->descriptores[desc] = m;
+	return desc;
 }
 
-int sis_lock(){
+/*
+ * Abre un mutex existente. Devuelve el descriptor, o -1 si no existe o
+ * el proceso no tiene descriptores libres.
+ */
+int sis_abrir_mutex(){
+	char nombre[MAX_NOM_MUT+1];
+	int desc;
+	mutex *m;
+
+	if (leer_nombre_mutex((char *)leer_registro(1), nombre)<0)
+		return -1;
+	if ((m=buscar_mutex(nombre))==NULL || (desc=descriptor_libre())<0)
+		return -1;
+
+	m->abiertos++;
+	p_proc_actual->descriptores[desc] = m;
+	return desc;
+}
 
+/*
+ * Bloquea un mutex. Si lo tiene otro proceso espera en su cola hasta que
+ * se lo entreguen. Es un error volver a bloquear un mutex no recursivo.
+ * La biblioteca solo llama aqui si no ha podido tomar el mutex en modo
+ * usuario. Con varias UCP los procesos de las demas pueden cambiar la
+ * palabra en modo usuario mientras se trata, por lo que se modifica con
+ * operaciones atomicas.
+ */
+int sis_lock(){
+	mutex *m;
+	palabra_mutex *pm;
+	unsigned int palabra;
+
+	if ((m=obtener_mutex((unsigned int)leer_registro(1)))==NULL)
+		return -1;
+	pm = &m->compartida;
+
+	if (es_propietario(m)) {
+		if (pm->tipo==NO_RECURSIVO)
+			return -1;
+		pm->num_bloqueos++;
+		return 0;
+	}
 
+	// se toma si esta libre o se marca que hay esperas, reintentando si
+	// la palabra cambia entretanto
+	do {
+		palabra = pm->palabra;
+		if (palabra==0 && __sync_bool_compare_and_swap(&pm->palabra,
+				0, MARCA_MUTEX(p_proc_actual))) {
+			pm->num_bloqueos = 1;
+			return 0;
+		}
+	} while (palabra==0 || (!(palabra & ESPERAS_MUTEX) &&
+		 !__sync_bool_compare_and_swap(&pm->palabra, palabra,
+				palabra | ESPERAS_MUTEX)));
+
+	// el propietario tendra que entrar al nucleo para soltarlo, y al
+	// despertar ya es el propietario (ver soltar_mutex)
+	p_proc_actual->esperando_mutex = m;
+	heredar_prioridad(propietario_mutex(m), p_proc_actual);
+	bloquear(&m->bloqueados);
+	return 0;
 }
 
+/*
+ * Desbloquea un mutex que tiene el proceso actual. Con la ultima
+ * liberacion de un recursivo se entrega al siguiente de la cola.
+ */
 int sis_unlock(){
+	mutex *m;
+
+	if ((m=obtener_mutex((unsigned int)leer_registro(1)))==NULL ||
+	    !es_propietario(m))
+		return -1;
 
+	if (--m->compartida.num_bloqueos==0)
+		soltar_mutex(m);
+	return 0;
 }
 
+/*
+ * Devuelve en el segundo argumento la direccion de la palabra compartida
+ * del mutex asociado a un descriptor, para el camino rapido de la
+ * biblioteca. Devuelve ademas la marca del proceso actual.
+ */
+int sis_palabra_mutex(){
+	mutex *m;
+	palabra_mutex **dir;
+
+	if ((m=obtener_mutex((unsigned int)leer_registro(1)))==NULL)
+		return -1;
+	dir = (palabra_mutex **)leer_registro(2);
+
+	accesoParam = 1;
+	*dir = &m->compartida;
+	accesoParam = 0;
+	return MARCA_MUTEX(p_proc_actual);
+}
 
+/*
+ * Cierra un descriptor de mutex.
+ */
 int sis_cerrar_mutex(){
+	unsigned int desc = (unsigned int)leer_registro(1);
 
-
+	if (obtener_mutex(desc)==NULL)
+		return -1;
+	cerrar_descriptor(desc);
+	return 0;
 }
 
 
 int sis_leer_caracter(){
-	
-	int lvl_interrupciones = fijar_nivel_int(NIVEL_2);
-	// Bloqueo si vacio -> con loop en vez de condicion
-	while(caracteresEnBuffer == 0){
-		p_proc_actual->estado = BLOQUEADO;
-		p_proc_actual->bloqueo_por_lectura = 1;
-		int lvl_interrupciones = fijar_nivel_int(NIVEL_3);
-		eliminar_elem(&lista_listos, p_proc_actual);
-		insertar_ultimo(&lista_bloqueados, p_proc_actual);
+	char car;
+	int lvl_interrupciones, latencia;
+
+	// Bloqueo si vacio: la comprobacion y el bloqueo han de hacerse
+	// sin que se cuele la interrupcion de terminal entre medias
+	if(caracteresEnBuffer() == 0){
+		lvl_interrupciones = fijar_nivel_int(NIVEL_2);
+		while(caracteresEnBuffer() == 0){
+			bloquear(&lista_espera_terminal);
+		}
+		fijar_nivel_int(lvl_interrupciones);
+	}
+
+	// Recuperar primer caracter: no hace falta elevar el nivel, ya que
+	// la interrupcion solo escribe en posiciones libres y nunca mueve
+	// inicioBuffer
+	car = bufferCaracteres[inicioBuffer & MASCARA_BUF_TERM];
+	latencia = numTicks - tickCaracteres[inicioBuffer & MASCARA_BUF_TERM];
+	inicioBuffer++;
+
+	lecturas_term++;
+	latencia_total_term += latencia;
+	if (latencia > latencia_maxima_term)
+		latencia_maxima_term = latencia;
+
+	return car;
+}
+
+/*
+ * Lee hasta n caracteres del terminal en un buffer de usuario con una
+ * sola llamada. Se bloquea hasta haber leido al menos vmin caracteres
+ * (como mucho n) o hasta que pasen vtime ticks desde la llamada (0 para
+ * esperar sin plazo). Con vmin 0 no se bloquea. Devuelve el numero de
+ * caracteres leidos, o -1 si los argumentos no son validos.
+ */
+int sis_leer_caracteres(){
+	char *buf;
+	int n, vmin, vtime;
+	int leidos = 0, plazo = 0;
+	int lvl_interrupciones;
+
+	buf = (char *)leer_registro(1);
+	n = (int)leer_registro(2);
+	vmin = (int)leer_registro(3);
+	vtime = (int)leer_registro(4);
+
+	if (buf == NULL || n < 0 || vmin < 0 || vtime < 0)
+		return -1;
+	if (vmin > n)
+		vmin = n;
+	if (vtime > 0)
+		plazo = numTicks + vtime;
+
+	for(;;){
+		// copia lo que haya sin elevar el nivel, como sis_leer_caracter
+		accesoParam = 1;
+		while(leidos < n && caracteresEnBuffer() > 0){
+			buf[leidos++] = bufferCaracteres[inicioBuffer & MASCARA_BUF_TERM];
+			inicioBuffer++;
+		}
+		accesoParam = 0;
+
+		if (leidos >= vmin)
+			break;
+
+		// la interrupcion de reloj tampoco debe colarse: podria vencer
+		// el plazo entre la comprobacion y el bloqueo
+		lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+		if (caracteresEnBuffer() == 0){
+			if (plazo && plazo <= numTicks){
+				fijar_nivel_int(lvl_interrupciones);
+				break;
+			}
+			if (plazo)
+				poner_temporizador(plazo);
+			bloquear(&lista_espera_terminal);
+		}
 		fijar_nivel_int(lvl_interrupciones);
+	}
+
+	return leidos;
+
+
+}
+
+/*
+ * Registra el anillo de llamadas del proceso actual (NULL lo anula).
+ */
+int sis_registrar_anillo(){
+	p_proc_actual->anillo = (struct anillo_llamsis *)leer_registro(1);
+	return 0;
+}
+
+/*
+ * Indica si una llamada puede ir en el anillo. No se admiten las que
+ * terminan el proceso o pueden bloquearlo: se ejecutarian con el anillo
+ * a medias y con accesoParam activo mientras corren otros procesos.
+ * Tampoco cerrar_mutex: la biblioteca guarda la palabra de cada
+ * descriptor (ver sis_palabra_mutex) y, si el cierre no pasa por ella,
+ * el siguiente mutex abierto con ese descriptor usaria la del cerrado.
+ */
+static int admitida_en_anillo(long llamada){
+	switch (llamada){
+	case TERMINAR_PROCESO:
+	case DORMIR:
+	case CREAR_MUTEX:
+	case LOCK:
+	case CERRAR_MUTEX:
+	case LEER_CARACTER:
+	case LEER_CARACTERES:
+	case ENTRAR_ANILLO:
+	case FIN_PERIODO:
+		return 0;
+	default:
+		return llamada >= 0 && llamada < NSERVICIOS;
+	}
+}
 
-		// Cambio de proceso actual con cambio de contexto
-		BCP *proc_bloq = p_proc_actual;
-		p_proc_actual = planificador();
-		cambio_contexto(&(proc_bloq->contexto_regs), &(p_proc_actual->contexto_regs));
+/*
+ * Ejecuta todas las peticiones pendientes del anillo del proceso actual
+ * con una sola llamada. Cada peticion se trata como si llegara por
+ * llamsis: sus argumentos se copian a los registros 1..n y se invoca el
+ * servicio de tabla_servicios. El resultado se deja en la propia entrada;
+ * las llamadas no admitidas (ver admitida_en_anillo) dan -1.
+ * Devuelve el numero de peticiones ejecutadas, o -1 si no hay anillo.
+ */
+int sis_entrar_anillo(){
+	struct anillo_llamsis *anillo = p_proc_actual->anillo;
+	struct peticion_llamsis *pet;
+	int i, hechas = 0, acceso_previo;
+	long resultado;
+
+	if (anillo == NULL)
+		return -1;
+
+	// el anillo esta en memoria del proceso
+	acceso_previo = accesoParam;
+	accesoParam = 1;
+	while (anillo->completadas != anillo->enviadas){
+		pet = &anillo->peticiones[anillo->completadas & (TAM_ANILLO-1)];
+		if (!admitida_en_anillo(pet->llamada))
+			pet->resultado = -1;
+		else {
+			for (i=0; i<MAX_ARGS_ANILLO; i++)
+				escribir_registro(i+1, pet->args[i]);
+			// el servicio gestiona accesoParam como si viniera
+			// de llamsis; al volver se recupera el del anillo
+			accesoParam = 0;
+			resultado = (tabla_servicios[pet->llamada].fservicio)();
+			accesoParam = 1;
+			pet->resultado = resultado;
+		}
+		anillo->completadas++;
+		hechas++;
 	}
+	accesoParam = acceso_previo;
 
-	// Recuperar primer caracter
-	char car = bufferCaracteres[0];
+	return hechas;
+}
 
-	/*Reordenamos el buffer*/
-	printk("Reasignado buffer, tamanio = %d\n", caracteresEnBuffer);
-	caracteresEnBuffer--;
-	int i;
-	for (i = 0; i < caracteresEnBuffer; i++){
-		bufferCaracteres[i] = bufferCaracteres[i+1];
+/*
+ * Fija el valor nice del proceso actual (de NICE_MIN a NICE_MAX), que
+ * determina su peso en el reparto equitativo. Con la planificacion
+ * multinivel se guarda pero no tiene efecto.
+ */
+int sis_fijar_prioridad(){
+	int nice;
+	int lvl_interrupciones;
+
+	nice = (int)leer_registro(1);
+	if (nice < NICE_MIN || nice > NICE_MAX)
+		return -1;
+
+	if (clase_de(p_proc_actual)!=&clases_planificacion[PLAN_CFS]) {
+		p_proc_actual->nice = nice;
+		return 0;
 	}
+
+	// el tiempo ya ejecutado se cuenta con el peso anterior
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	clase_actual->eliminar(p_proc_actual);
+	p_proc_actual->nice = nice;
+	clase_actual->insertar(p_proc_actual);
 	fijar_nivel_int(lvl_interrupciones);
 
-	return car;
+	return 0;
+}
+
+/*
+ * Convierte al proceso actual en un proceso periodico de tiempo real
+ * (o cambia sus parametros, en ticks): en cada periodo dispone de
+ * presupuesto ticks de UCP y debe terminar antes de plazo ticks. Solo
+ * se admite si la utilizacion total de los procesos de tiempo real no
+ * supera LIMITE_UTILIZACION. Devuelve 0 si se admite y -1 si no.
+ */
+int sis_fijar_tiempo_real(){
+	int periodo, presupuesto, plazo, utilizacion, anterior;
+	int lvl_interrupciones;
+
+	periodo = (int)leer_registro(1);
+	presupuesto = (int)leer_registro(2);
+	plazo = (int)leer_registro(3);
+	if (presupuesto <= 0 || presupuesto > plazo || plazo > periodo)
+		return -1;
+
+	/* milesimas de UCP, redondeando hacia arriba */
+	utilizacion = (presupuesto * 1000 + plazo - 1) / plazo;
+	anterior = p_proc_actual->tiempo_real ? p_proc_actual->utilizacion : 0;
+	if (utilizacion_tiempo_real - anterior + utilizacion > LIMITE_UTILIZACION)
+		return -1;
+
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	clase_de(p_proc_actual)->eliminar(p_proc_actual);
+	if (!p_proc_actual->tiempo_real) {
+		p_proc_actual->periodos = 0;
+		p_proc_actual->fallos_plazo = 0;
+		p_proc_actual->agotamientos = 0;
+	}
+	p_proc_actual->tiempo_real = 1;
+	p_proc_actual->periodo = periodo;
+	p_proc_actual->presupuesto = presupuesto;
+	p_proc_actual->plazo = plazo;
+	p_proc_actual->utilizacion = utilizacion;
+	utilizacion_tiempo_real += utilizacion - anterior;
+	nuevo_periodo(p_proc_actual, numTicks);
+	clase_tiempo_real.insertar(p_proc_actual);
+	fijar_nivel_int(lvl_interrupciones);
+
+	return 0;
+}
+
+/*
+ * Un proceso de tiempo real termina el trabajo de su periodo y espera
+ * la activacion del siguiente. Devuelve los plazos incumplidos hasta
+ * ahora o -1 si el proceso no es de tiempo real.
+ */
+int sis_fin_periodo(){
+	int siguiente;
+	int lvl_interrupciones;
 
+	if (!p_proc_actual->tiempo_real)
+		return -1;
+
+	lvl_interrupciones = fijar_nivel_int(NIVEL_3);
+	comprobar_plazo(p_proc_actual);
+	siguiente = p_proc_actual->inicio_periodo + p_proc_actual->periodo;
+	if (siguiente <= numTicks) {
+		/* va con retraso: el siguiente periodo ya esta activo */
+		clase_tiempo_real.eliminar(p_proc_actual);
+		nuevo_periodo(p_proc_actual, siguiente);
+		clase_tiempo_real.insertar(p_proc_actual);
+	}
+	else {
+		poner_temporizador(siguiente);
+		bloquear(&lista_periodos);
+	}
+	fijar_nivel_int(lvl_interrupciones);
 
+	return p_proc_actual->fallos_plazo;
 }
 
 int main(){
-	/* se llega con las interrupciones prohibidas */
+	BCP *proceso;
+	int i;
 
-	instal_man_int(EXC_ARITM, exc_arit); 
-	instal_man_int(EXC_MEM, exc_mem); 
-	instal_man_int(INT_RELOJ, int_reloj); 
-	instal_man_int(INT_TERMINAL, int_terminal); 
-	instal_man_int(LLAM_SIS, tratar_llamsis); 
-	instal_man_int(INT_SW, int_sw); 
+	/* se llega con las interrupciones prohibidas */
+	tomar_nucleo();
+
+	instal_man_int(EXC_ARITM, MANEJADOR(exc_arit)); 
+	instal_man_int(EXC_MEM, MANEJADOR(exc_mem)); 
+	instal_man_int(INT_RELOJ, MANEJADOR(int_reloj)); 
+	instal_man_int(INT_TERMINAL, MANEJADOR(int_terminal)); 
+	instal_man_int(LLAM_SIS, MANEJADOR(tratar_llamsis)); 
+	instal_man_int(INT_SW, MANEJADOR(int_sw)); 
+#if NUM_UCPS > 1
+	instal_man_int(INT_IPI, MANEJADOR(int_ipi));
+#endif
 
 	iniciar_cont_int();		/* inicia cont. interr. */
 	iniciar_cont_reloj(TICK);	/* fija frecuencia del reloj */
 	iniciar_cont_teclado();		/* inici cont. teclado */
 
 	iniciar_tabla_proc();		/* inicia BCPs de tabla de procesos */
+	iniciar_mutex();		/* inicia la tabla de mutex */
+	elegir_clase();			/* fija la clase de planificacion */
+	for (i=0; i<NUM_UCPS; i++)
+		tabla_ucps[i].proximo_envejecimiento = PERIODO_ENVEJECIMIENTO;
+
+#if NUM_UCPS > 1
+	/* arranca las demas UCP, que esperan a tener algo que robar */
+	if (arrancar_ucps(NUM_UCPS, arrancar_ucp, arranque_proceso)<0)
+		printk("-> NO SE PUEDEN ARRANCAR %d UCP: SE USA UNA\n",
+				NUM_UCPS);
+	else
+		num_ucps = NUM_UCPS;
+#endif
+	/* el tiempo virtual supone que solo hay una UCP */
+	tiempo_virtual = getenv("TIEMPO_VIRTUAL") != NULL && num_ucps == 1;
 
 	/* crea proceso inicial */
 	if (crear_tarea((void *)"init")<0)
 		panico("no encontrado el proceso inicial");
 	
 	/* activa proceso inicial */
-	p_proc_actual=planificador();
+	proceso=planificador();
+	p_proc_actual=proceso;
+	trazar(EV_CAMBIO, -1, p_proc_actual->id);
+	iniciar_cuenta();
 	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
 	panico("S.O. reactivado inesperadamente");
 	return 0;
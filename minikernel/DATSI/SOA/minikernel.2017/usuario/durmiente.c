@@ -0,0 +1,26 @@
+/*
+ * usuario/durmiente.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que duerme repetidamente. Lo usa prueba_rueda
+ * para tener muchos temporizadores activos a la vez.
+ */
+
+#include "servicios.h"
+
+#define NUM_SIESTAS 5	/* nmero de veces que duerme */
+
+int main(){
+	int i, id;
+
+	id=obtener_id_pr();
+	for (i=0; i<NUM_SIESTAS; i++)
+		dormir(1 + id%2);
+
+	printf("durmiente (%d): termina\n", id);
+	return 0;
+}
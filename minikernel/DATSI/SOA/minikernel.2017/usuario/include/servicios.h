@@ -19,6 +19,9 @@
 #ifndef SERVICIOS_H
 #define SERVICIOS_H
 
+#include "traza.h"	/* eventos que devuelve leer_traza */
+#include "latencias.h"	/* estadisticas que devuelve leer_latencias */
+
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
 
@@ -26,13 +29,56 @@
 /* Evita el uso del printf de la bilioteca estndar */
 #define printf escribirf
 
+/* Modos del buffer de salida (ver modo_salida) */
+#define SALIDA_POR_LINEAS 0	/* se vacia al escribir un fin de linea */
+#define SALIDA_COMPLETA 1	/* se vacia cuando se llena */
+#define SALIDA_SIN_BUFFER 2	/* cada escritura va directa al nucleo */
+
 struct tiempos_ejec {
 	int usuario;
 	int sistema;
 };
 
-/* Funcion de biblioteca */
+/* Tiempos en ticks y en nanosegundos; empieza igual que tiempos_ejec */
+struct tiempos_ejec_ns {
+	int usuario;
+	int sistema;
+	long long usuario_ns;
+	long long sistema_ns;
+};
+
+/*
+ * Anillo de llamadas al sistema: se registra una vez con
+ * registrar_anillo, se encolan peticiones con encolar_llamsis y se
+ * ejecutan todas las pendientes con una sola llamada entrar_anillo.
+ * El resultado de cada peticion queda en su campo resultado. Los
+ * argumentos se pasan convertidos a long, como en llamsis. Las llamadas
+ * que terminan el proceso o pueden bloquearlo (terminar_proceso, dormir,
+ * crear_mutex, lock, leer_caracter(es), fin_periodo) no se admiten en el
+ * anillo y dan -1, igual que cerrar_mutex, que ha de pasar por la
+ * biblioteca.
+ */
+#define TAM_ANILLO 32		/* entradas del anillo (potencia de 2) */
+#define MAX_ARGS_ANILLO 4	/* argumentos por peticion */
+
+struct peticion_llamsis {
+	long llamada;
+	long args[MAX_ARGS_ANILLO];
+	long resultado;
+};
+
+struct anillo_llamsis {
+	volatile unsigned int enviadas;
+	volatile unsigned int completadas;
+	struct peticion_llamsis peticiones[TAM_ANILLO];
+};
+
+/* Funciones de biblioteca */
 int escribirf(const char *formato, ...);
+int vaciar();
+int modo_salida(int modo);
+struct peticion_llamsis *encolar_llamsis(struct anillo_llamsis *anillo,
+		int llamada, int nargs, ...);
 
 /* Llamadas al sistema proporcionadas */
 int crear_proceso(char *prog);
@@ -41,6 +87,9 @@ int escribir(char *texto, unsigned int longi);
 int obtener_id_pr();
 int dormir(unsigned int segundos);
 int tiempos_proceso(struct tiempos_ejec *t_ejec);
+int tiempos_proceso_ns(struct tiempos_ejec_ns *t_ejec);
+int leer_traza(struct evento_traza *eventos, int max);
+int leer_latencias(struct latencias_llamsis *lat, int max);
 
 int crear_mutex(char *nombre, int tipo);
 int abrir_mutex(char *nombre);
@@ -48,6 +97,12 @@ int lock(unsigned int mutexid);
 int unlock(unsigned int mutexid);
 int cerrar_mutex(unsigned int mutexid);
 int leer_caracter();
+int leer_caracteres(char *buf, int n, int vmin, int vtime);
+int fijar_prioridad(int nice);
+int fijar_tiempo_real(int periodo, int presupuesto, int plazo);
+int fin_periodo();
+int registrar_anillo(struct anillo_llamsis *anillo);
+int entrar_anillo();
 
 #endif /* SERVICIOS_H */
 
@@ -84,6 +84,66 @@ ALGO COMENTE ESTA PARTE Y DESCOMENTE LA PRUEBA CORRESPONDIENTE */
 		printf("Error creando prueba_RR2\n");
 */
 
+/* PRUEBA DE LA RUEDA DE TEMPORIZADORES
+	if (crear_proceso("prueba_rueda")<0)
+		printf("Error creando prueba_rueda\n");
+*/
+
+/* PRUEBA DE LA CACHE DE IMAGENES
+	if (crear_proceso("prueba_imagenes")<0)
+		printf("Error creando prueba_imagenes\n");
+*/
+
+/* PRUEBA DE LA LECTURA DE VARIOS CARACTERES
+	if (crear_proceso("prueba_leer")<0)
+		printf("Error creando prueba_leer\n");
+*/
+
+/* PRUEBA DEL ANILLO DE LLAMADAS AL SISTEMA
+	if (crear_proceso("prueba_anillo")<0)
+		printf("Error creando prueba_anillo\n");
+*/
+
+/* PRUEBA DEL CAMINO RAPIDO DE LOS MUTEX
+	if (crear_proceso("prueba_cerrojos")<0)
+		printf("Error creando prueba_cerrojos\n");
+*/
+
+/* PRUEBA DE LA HERENCIA DE PRIORIDAD
+	if (crear_proceso("prueba_inversion")<0)
+		printf("Error creando prueba_inversion\n");
+*/
+
+/* PRUEBA DEL REPARTO EQUITATIVO PONDERADO
+	if (crear_proceso("prueba_pesos")<0)
+		printf("Error creando prueba_pesos\n");
+*/
+
+/* PRUEBA DE LA PLANIFICACION DE TIEMPO REAL
+	if (crear_proceso("prueba_edf")<0)
+		printf("Error creando prueba_edf\n");
+*/
+
+/* PRUEBA DE LA LATENCIA DEL TERMINAL CON CARGA
+	if (crear_proceso("prueba_latencia")<0)
+		printf("Error creando prueba_latencia\n");
+*/
+
+/* PRUEBA DE LA CONTABILIDAD PRECISA DE TIEMPOS
+	if (crear_proceso("prueba_contabilidad")<0)
+		printf("Error creando prueba_contabilidad\n");
+*/
+
+/* VOLCADO DE LA TRAZA DEL NUCLEO (compilado con -DTRAZA=1)
+	if (crear_proceso("volcar_traza")<0)
+		printf("Error creando volcar_traza\n");
+*/
+
+/* LATENCIA DE CADA LLAMADA AL SISTEMA
+	if (crear_proceso("latencias")<0)
+		printf("Error creando latencias\n");
+*/
+
  /*PRUEBA DEL TERMINAL*/
 	if (crear_proceso("prueba_term")<0)
 		printf("Error creando prueba_term\n");
@@ -0,0 +1,45 @@
+/*
+ * usuario/inv_baja.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario de la prueba de inversin de prioridad: proceso
+ * de baja prioridad que tiene el mutex "inv" mientras hace cmputo.
+ */
+
+#include "servicios.h"
+
+#define TRABAJO 250	/* ticks de UCP que tiene el mutex */
+#define NICE_BAJA 10	/* prioridad en el reparto equitativo */
+
+/* ticks de UCP gastados por el proceso */
+static int ucp(){
+	struct tiempos_ejec t;
+
+	tiempos_proceso(&t);
+	return t.usuario+t.sistema;
+}
+
+int main(){
+	int desc, i, tot, j=5;
+
+	printf("inv_baja: comienza\n");
+	fijar_prioridad(NICE_BAJA);
+
+	if ((desc=abrir_mutex("inv"))<0 || lock(desc)<0)
+		printf("inv_baja: error en el mutex. NO DEBE APARECER\n");
+
+	while (ucp()<TRABAJO)
+		for (i=0; i<1000000; i++)
+			tot=j*i;
+	tot--;
+
+	printf("inv_baja: suelta el mutex\n");
+	unlock(desc);
+
+	printf("inv_baja: termina\n");
+	return 0;
+}
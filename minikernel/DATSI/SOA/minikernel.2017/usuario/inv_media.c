@@ -0,0 +1,28 @@
+/*
+ * usuario/inv_media.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario de la prueba de inversin de prioridad: proceso
+ * de prioridad media que solo hace cmputo durante un tiempo fijo.
+ */
+
+#include "servicios.h"
+
+#define DURACION 1500	/* ticks de tiempo real que est ejecutando */
+
+int main(){
+	int i, tot, j=5, fin;
+
+	fin=tiempos_proceso(0)+DURACION;
+	while (tiempos_proceso(0)<fin)
+		for (i=0; i<1000000; i++)
+			tot=j*i;
+	tot--;
+
+	printf("inv_media (%d): termina\n", obtener_id_pr());
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * usuario/latencias.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra la latencia de cada llamada al
+ * sistema: nmero de invocaciones y percentiles 50 y 99 y mximo del
+ * tiempo en la UCP y, para las que se bloquean, del tiempo bloqueado.
+ * Los percentiles salen de histogramas logartmicos, as que son la
+ * cota superior de su cubeta. Antes lanza prueba_imagenes y
+ * prueba_dormir como carga y espera a que terminen.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+#define SEGUNDOS 8		/* bastan para que termine la carga */
+
+static struct latencias_llamsis lat[NSERVICIOS];
+static const char *nombres[NSERVICIOS]=NOMBRES_LLAMSIS;
+
+/*
+ * Cota superior, en microsegundos, del percentil p de un histograma
+ * con n muestras; no pasa del maximo observado. La ultima cubeta no
+ * tiene cota superior, asi que si el percentil cae en ella se da el
+ * maximo.
+ */
+static double percentil(unsigned int *hist, unsigned int n, int p,
+			long long max){
+	unsigned int acum=0;
+	int i;
+
+	for (i=0; i<NUM_CUBETAS_LAT-1; i++) {
+		acum+=hist[i];
+		if (acum*100ULL >= (unsigned long long)p*n)
+			break;
+	}
+	if ((i<NUM_CUBETAS_LAT-1) && ((1LL<<(i+1)) < max))
+		max=1LL<<(i+1);
+	return (double)max/1000;
+}
+
+int main(){
+	int i, n;
+	struct latencias_llamsis *l;
+
+	printf("latencias: comienza\n");
+
+	if (crear_proceso("prueba_dormir")<0)
+		printf("Error creando prueba_dormir\n");
+	if (crear_proceso("prueba_imagenes")<0)
+		printf("Error creando prueba_imagenes\n");
+	dormir(SEGUNDOS);
+
+	n=leer_latencias(lat, NSERVICIOS);
+	if (n>NSERVICIOS)
+		n=NSERVICIOS;
+
+	printf("%-20s %6s | %9s %9s %9s | %6s %9s %9s %9s\n",
+		"llamada (us)", "n", "ucp p50", "p99", "max",
+		"bloq", "p50", "p99", "max");
+	for (i=0; i<n; i++) {
+		l=&lat[i];
+		if (l->llamadas==0)
+			continue;
+		printf("%-20s %6u | %9.1f %9.1f %9.1f |", nombres[i],
+			l->llamadas, percentil(l->cpu, l->llamadas, 50, l->max_cpu),
+			percentil(l->cpu, l->llamadas, 99, l->max_cpu),
+			(double)l->max_cpu/1000);
+		if (l->bloqueos)
+			printf(" %6u %9.1f %9.1f %9.1f\n", l->bloqueos,
+				percentil(l->bloqueado, l->bloqueos, 50,
+					l->max_bloqueado),
+				percentil(l->bloqueado, l->bloqueos, 99,
+					l->max_bloqueado),
+				(double)l->max_bloqueado/1000);
+		else
+			printf(" %6u\n", 0);
+	}
+
+	printf("latencias: termina\n");
+	return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ *  usuario/lib/misc.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ *  Fernando Prez Costoya
+ *
+ */
+
+/*
+ *
+ * Implementacin en fuente del mdulo "misc" de la biblioteca,
+ * alternativa a los binarios misc.o_32 y misc.o_64 (se usa con
+ * "make MISC=fuente" y, obligatoriamente, con varias UCP).
+ *
+ * Contiene la funcin de arranque de los programas, la que realiza las
+ * llamadas al sistema y la versin de printf de los programas. Los
+ * registros del procesador los proporciona el HAL al cargar el programa:
+ *
+ *	- reglib apunta al vector de registros de la nica UCP.
+ *	- Con varias UCP cada una tiene sus registros, y el HAL fija
+ *	  reglib_ucp a una funcin que devuelve los de la UCP que la
+ *	  invoca.
+ *
+ * La instruccin de llamada al sistema (trap) enva SIGUSR1 al propio
+ * hilo, que es el que simula la UCP en que ejecuta el proceso.
+ *
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+int escribir(char *texto, unsigned int longi);
+int terminar_proceso();
+
+long *reglib;			/* registros de la UCP */
+long *(*reglib_ucp)();		/* registros de la UCP actual (varias UCP) */
+
+static long *registros(){
+	return reglib_ucp ? reglib_ucp() : reglib;
+}
+
+static long leer_registro(int nreg){
+	return registros()[nreg];
+}
+
+static void escribir_registro(int nreg, long valor){
+	registros()[nreg]=valor;
+}
+
+/*
+ * La seal se dirige al hilo y no al proceso UNIX para que la trate la
+ * misma UCP que ha hecho la llamada.
+ */
+static void trap(){
+	syscall(SYS_tgkill, getpid(), syscall(SYS_gettid), SIGUSR1);
+}
+
+int escribirf(const char *formato, ...){
+	char buf[1024];
+	va_list ap;
+	int n;
+
+	va_start(ap, formato);
+	n=vsnprintf(buf, sizeof(buf), formato, ap);
+	va_end(ap);
+	if (n>0)
+		escribir(buf, strlen(buf));
+	return n;
+}
+
+/*
+ * Deja el cdigo de la llamada en el registro 0 y los argumentos en los
+ * siguientes, y devuelve el resultado que queda en el registro 0.
+ */
+int llamsis(int llamada, int nargs, ... /* args */){
+	va_list ap;
+	int i;
+
+	escribir_registro(0, llamada);
+	va_start(ap, nargs);
+	for (i=1; nargs; nargs--, i++)
+		escribir_registro(i, va_arg(ap, long));
+	va_end(ap);
+	trap();
+	return leer_registro(0);
+}
+
+/*
+ * Primera funcin de usuario de un proceso: ejecuta el programa y, si
+ * vuelve de main, termina el proceso.
+ */
+void start(void (*pc)()){
+	pc();
+	terminar_proceso();
+}
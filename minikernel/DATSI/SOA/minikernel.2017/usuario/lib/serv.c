@@ -16,7 +16,10 @@
  *
  */
 
+#include <string.h>
+#include <stdarg.h>
 #include "llamsis.h"
+#include "const.h"
 #include "servicios.h"
 
 /* Funcin del mdulo "misc" que prepara el cdigo de la llamada
@@ -26,6 +29,46 @@
 
 int llamsis(int llamada, int nargs, ... /* args */);
 
+/*
+ * Parte de un mutex del nucleo que la biblioteca modifica directamente
+ * (misma definicion que en kernel.h)
+ */
+struct palabra_mutex {
+	volatile unsigned int palabra;	/* marca del propietario | esperas */
+	int tipo;			/* NO_RECURSIVO|RECURSIVO */
+	int num_bloqueos;		/* veces que lo ha bloqueado */
+};
+
+/*
+ * Datos propios de cada proceso. Como todos los procesos de un mismo
+ * programa comparten las variables globales de la biblioteca, se guardan
+ * en el area de usuario que el nucleo reserva al principio de la pila de
+ * cada proceso (ver TAM_AREA_USUARIO en const.h). El nucleo la deja a
+ * cero, por lo que el modo inicial es SALIDA_POR_LINEAS.
+ */
+#define TAM_BUF_SALIDA 768
+
+struct area_usuario {
+	int modo_salida;		/* SALIDA_POR_LINEAS|COMPLETA|SIN_BUFFER */
+	int ocupados;			/* caracteres pendientes en el buffer */
+	unsigned int marca;		/* marca del proceso en los mutex */
+	struct palabra_mutex *palabras[NUM_MUT_PROC]; /* de sus mutex */
+	char buf_salida[TAM_BUF_SALIDA];
+};
+
+/* el area de usuario ha de caber en el espacio reservado */
+typedef char comprobar_area_usuario
+	[(sizeof(struct area_usuario)<=TAM_AREA_USUARIO) ? 1 : -1];
+
+/* La pila esta alineada a su tamao: basta con redondear hacia abajo
+   la direccion de una variable local */
+static struct area_usuario *area_usuario(){
+	char local;
+
+	return (struct area_usuario *)
+		((unsigned long)&local & ~((unsigned long)TAM_PILA - 1));
+}
+
 
 /*
  *
@@ -38,10 +81,47 @@ int crear_proceso(char *prog){
 	return llamsis(CREAR_PROCESO, 1, (long)prog);
 }
 int terminar_proceso(){
+	vaciar();
 	return llamsis(TERMINAR_PROCESO, 0);
 }
 int escribir(char *texto, unsigned int longi){
-	return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
+	struct area_usuario *area=area_usuario();
+
+	/* sin buffer, o no cabe ni con el buffer vacio: se escribe directo */
+	if ((area->modo_salida==SALIDA_SIN_BUFFER) || (longi>TAM_BUF_SALIDA)) {
+		vaciar();
+		return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
+	}
+	if (area->ocupados+longi>TAM_BUF_SALIDA)
+		vaciar();
+
+	memcpy(area->buf_salida+area->ocupados, texto, longi);
+	area->ocupados+=longi;
+
+	if ((area->modo_salida==SALIDA_POR_LINEAS) &&
+	    (memchr(texto, '\n', longi)!=NULL))
+		vaciar();
+	return 0;
+}
+int vaciar(){
+	struct area_usuario *area=area_usuario();
+	int ocupados=area->ocupados;
+
+	if (ocupados==0)
+		return 0;
+	area->ocupados=0;
+	return llamsis(ESCRIBIR, 2, (long)area->buf_salida, (long)ocupados);
+}
+int modo_salida(int modo){
+	struct area_usuario *area=area_usuario();
+	int anterior=area->modo_salida;
+
+	if ((modo!=SALIDA_POR_LINEAS) && (modo!=SALIDA_COMPLETA) &&
+	    (modo!=SALIDA_SIN_BUFFER))
+		return -1;
+	vaciar();
+	area->modo_salida=modo;
+	return anterior;
 }
 /** Nuevos practica **/
 
@@ -56,23 +136,136 @@ int dormir(unsigned int segundos){
 int tiempos_proceso(struct tiempos_ejec *t_ejec){
 	return llamsis(TIEMPOS_PROCESO, 1, (long) t_ejec);
 }
+int tiempos_proceso_ns(struct tiempos_ejec_ns *t_ejec){
+	return llamsis(TIEMPOS_PROCESO_NS, 1, (long) t_ejec);
+}
+int leer_traza(struct evento_traza *eventos, int max){
+	return llamsis(LEER_TRAZA, 2, (long) eventos, (long) max);
+}
+int leer_latencias(struct latencias_llamsis *lat, int max){
+	return llamsis(LEER_LATENCIAS, 2, (long) lat, (long) max);
+}
 int crear_mutex(char *nombre, int tipo){
 	return llamsis(CREAR_MUTEX, 2, (long) nombre, (long) tipo);
 }
 int abrir_mutex(char *nombre){
 	return llamsis(ABRIR_MUTEX, 1, (long)nombre);
 }
+
+/*
+ * Camino rapido de lock y unlock: si el mutex esta libre se toma, y si
+ * nadie espera se suelta, con una operacion atomica sobre su palabra y
+ * sin entrar al nucleo. Solo cuando hay competencia se llama a lock o
+ * unlock, que bloquean al proceso en la cola del mutex o entregan el
+ * mutex al primero de ella. La palabra de cada descriptor se pide al
+ * nucleo la primera vez que se usa.
+ */
+static struct palabra_mutex *palabra_mutex(struct area_usuario *area,
+		unsigned int mutexid){
+	int marca;
+
+	if (mutexid>=NUM_MUT_PROC)
+		return NULL;
+	if (area->palabras[mutexid]==NULL) {
+		marca=llamsis(PALABRA_MUTEX, 2, (long)mutexid,
+				(long)&area->palabras[mutexid]);
+		if (marca<0)
+			return NULL;
+		area->marca=marca;
+	}
+	return area->palabras[mutexid];
+}
 int lock(unsigned int mutexid){
+	struct area_usuario *area=area_usuario();
+	struct palabra_mutex *pm=palabra_mutex(area, mutexid);
+
+	if (pm) {
+		if (__sync_bool_compare_and_swap(&pm->palabra, 0, area->marca)) {
+			pm->num_bloqueos=1;
+			return 0;
+		}
+		if ((pm->palabra & ~ESPERAS_MUTEX)==area->marca) {
+			if (pm->tipo==NO_RECURSIVO)
+				return -1;
+			pm->num_bloqueos++;
+			return 0;
+		}
+	}
 	return llamsis(LOCK, 1, (long)mutexid);
 }
 int unlock(unsigned int mutexid){
+	struct area_usuario *area=area_usuario();
+	struct palabra_mutex *pm=palabra_mutex(area, mutexid);
+
+	if (pm && ((pm->palabra & ~ESPERAS_MUTEX)==area->marca)) {
+		if (pm->num_bloqueos>1) {
+			pm->num_bloqueos--;
+			return 0;
+		}
+		pm->num_bloqueos=0;
+		if (__sync_bool_compare_and_swap(&pm->palabra, area->marca, 0))
+			return 0;
+		/* hay procesos esperando: el nucleo entrega el mutex */
+		pm->num_bloqueos=1;
+	}
 	return llamsis(UNLOCK, 1, (long)mutexid);
 }
 int cerrar_mutex(unsigned int mutexid){
+	if (mutexid<NUM_MUT_PROC)
+		area_usuario()->palabras[mutexid]=NULL;
 	return llamsis(CERRAR_MUTEX, 1, (long)mutexid);
 }
 int leer_caracter(){
+	vaciar();
 	return llamsis(LEER_CARACTER,0);
 }
+int leer_caracteres(char *buf, int n, int vmin, int vtime){
+	vaciar();
+	return llamsis(LEER_CARACTERES, 4, (long)buf, (long)n, (long)vmin,
+			(long)vtime);
+}
+int fijar_prioridad(int nice){
+	return llamsis(FIJAR_PRIORIDAD, 1, (long)nice);
+}
+int fijar_tiempo_real(int periodo, int presupuesto, int plazo){
+	return llamsis(FIJAR_TIEMPO_REAL, 3, (long)periodo, (long)presupuesto,
+		(long)plazo);
+}
+int fin_periodo(){
+	return llamsis(FIN_PERIODO, 0);
+}
+int registrar_anillo(struct anillo_llamsis *anillo){
+	return llamsis(REGISTRAR_ANILLO, 1, (long)anillo);
+}
+int entrar_anillo(){
+	vaciar();
+	return llamsis(ENTRAR_ANILLO, 0);
+}
+
+/*
+ * Aade una peticion al anillo. Devuelve la entrada, donde aparecera
+ * el resultado tras entrar_anillo, o NULL si el anillo esta lleno o
+ * hay demasiados argumentos. Las escrituras del anillo no pasan por el
+ * buffer de salida.
+ */
+struct peticion_llamsis *encolar_llamsis(struct anillo_llamsis *anillo,
+		int llamada, int nargs, ...){
+	struct peticion_llamsis *pet;
+	va_list args;
+	int i;
+
+	if ((nargs>MAX_ARGS_ANILLO) ||
+	    (anillo->enviadas-anillo->completadas>=TAM_ANILLO))
+		return NULL;
+
+	pet=&anillo->peticiones[anillo->enviadas & (TAM_ANILLO-1)];
+	pet->llamada=llamada;
+	va_start(args, nargs);
+	for (i=0; i<nargs; i++)
+		pet->args[i]=va_arg(args, long);
+	va_end(args);
+	anillo->enviadas++;
+	return pet;
+}
 
 
@@ -0,0 +1,64 @@
+/*
+ * usuario/periodico.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario de la prueba de tiempo real: segn el orden en
+ * que arranca se declara como proceso peridico con unos parmetros y
+ * en cada periodo gasta una cantidad de UCP. El tercero gasta ms que
+ * su presupuesto y el cuarto no debe ser admitido.
+ */
+
+#include "servicios.h"
+
+#define DURACION 1000	/* ticks que dura la prueba */
+
+struct parametros {
+	int periodo, presupuesto, plazo, trabajo;
+};
+
+/* parmetros de cada proceso, por orden de arranque (en ticks) */
+static struct parametros tabla[]={
+	{50, 10, 50, 6},	/* utilizacin 200 */
+	{100, 30, 80, 20},	/* utilizacin 375 */
+	{200, 40, 200, 60},	/* utilizacin 200, excede su presupuesto */
+	{100, 20, 100, 10}	/* utilizacin 200: no cabe */
+};
+
+/* los procesos de un mismo programa comparten las variables globales */
+static int arrancados=0;
+
+static int ucp(){
+	struct tiempos_ejec t;
+
+	tiempos_proceso(&t);
+	return t.usuario+t.sistema;
+}
+
+int main(){
+	int i, j=5, tot, inicio, fallos=0, n;
+	struct parametros *p;
+
+	p=&tabla[__sync_fetch_and_add(&arrancados, 1) % 4];
+	if (fijar_tiempo_real(p->periodo, p->presupuesto, p->plazo)<0) {
+		printf("periodico (%d): no admitido (%d/%d)\n", obtener_id_pr(),
+			p->presupuesto, p->plazo);
+		return 0;
+	}
+
+	for (n=0; n<DURACION/p->periodo; n++) {
+		inicio=ucp();
+		while (ucp()-inicio < p->trabajo)
+			for (i=0; i<10000; i++)
+				tot=j*i;
+		fallos=fin_periodo();
+	}
+	tot--;
+
+	printf("periodico (%d): periodo %d, trabajo %d/%d: %d plazos incumplidos\n",
+		obtener_id_pr(), p->periodo, p->trabajo, p->presupuesto, fallos);
+	return 0;
+}
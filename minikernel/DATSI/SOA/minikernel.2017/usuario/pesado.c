@@ -0,0 +1,42 @@
+/*
+ * usuario/pesado.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario de la prueba del reparto equitativo: fija su
+ * valor nice segn el orden en que arranca y gasta UCP durante un tiempo
+ * fijo, mostrando al final la UCP que ha obtenido.
+ */
+
+#include "servicios.h"
+
+#define DURACION 600	/* ticks de tiempo real que est ejecutando */
+
+/* valor nice de cada proceso, por orden de arranque */
+static int nices[]={0, 5, -5};
+
+/* los procesos de un mismo programa comparten las variables globales */
+static int arrancados=0;
+
+int main(){
+	int i, tot, j=5, fin, nice;
+	struct tiempos_ejec t;
+
+	nice=nices[__sync_fetch_and_add(&arrancados, 1) % 3];
+	if (fijar_prioridad(nice)<0)
+		printf("pesado: error en fijar_prioridad. NO DEBE APARECER\n");
+
+	fin=tiempos_proceso(0)+DURACION;
+	while (tiempos_proceso(0)<fin)
+		for (i=0; i<1000000; i++)
+			tot=j*i;
+	tot--;
+
+	tiempos_proceso(&t);
+	printf("pesado (%d): nice %d, %d ticks de UCP\n", obtener_id_pr(),
+		nice, t.usuario+t.sistema);
+	return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * usuario/prueba_anillo.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que compara el coste de hacer muchas llamadas al
+ * sistema sencillas una a una y agrupadas en el anillo de llamadas, que
+ * las ejecuta todas con una sola entrada al ncleo.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+#define TOT_LLAMADAS 200000	/* ponga las que considere oportuno */
+
+static void imp_tiempos(char *fase, int real, struct tiempos_ejec *t0,
+			struct tiempos_ejec *t1) {
+	printf("prueba_anillo: %s: %d llamadas en ticks: Real %d Usuario %d Sistema %d\n",
+		fase, TOT_LLAMADAS, real, t1->usuario-t0->usuario,
+		t1->sistema-t0->sistema);
+}
+
+int main(){
+	int i, id, t0, t1, m1, m2;
+	struct tiempos_ejec te0, te1;
+	struct anillo_llamsis anillo;
+	struct peticion_llamsis *pet;
+
+	printf("prueba_anillo: comienza\n");
+	id=obtener_id_pr();
+
+	/* una llamada por cada servicio */
+	t0=tiempos_proceso(&te0);
+	for (i=0; i<TOT_LLAMADAS; i++)
+		if (obtener_id_pr()!=id)
+			printf("prueba_anillo: resultado erroneo\n");
+	t1=tiempos_proceso(&te1);
+	imp_tiempos("una a una", t1-t0, &te0, &te1);
+
+	/* lotes de TAM_ANILLO servicios por llamada */
+	anillo.enviadas=anillo.completadas=0;
+	registrar_anillo(&anillo);
+
+	t0=tiempos_proceso(&te0);
+	for (i=0; i<TOT_LLAMADAS; i++) {
+		pet=encolar_llamsis(&anillo, OBTENER_ID_PR, 0);
+		if (pet==0) {
+			entrar_anillo();
+			pet=encolar_llamsis(&anillo, OBTENER_ID_PR, 0);
+		}
+	}
+	entrar_anillo();
+	t1=tiempos_proceso(&te1);
+	imp_tiempos("en el anillo", t1-t0, &te0, &te1);
+
+	/* comprueba que los resultados se escriben en cada entrada */
+	pet=encolar_llamsis(&anillo, ESCRIBIR, 2,
+		(long)"prueba_anillo: escrito desde el anillo\n", 39L);
+	encolar_llamsis(&anillo, OBTENER_ID_PR, 0);
+	if (entrar_anillo()!=2 || pet->resultado!=0 ||
+	    anillo.peticiones[(anillo.completadas-1) & (TAM_ANILLO-1)].resultado!=id)
+		printf("prueba_anillo: resultado erroneo\n");
+
+	/* las llamadas que bloquean no se admiten y no detienen el lote */
+	pet=encolar_llamsis(&anillo, DORMIR, 1, 1L);
+	encolar_llamsis(&anillo, OBTENER_ID_PR, 0);
+	if (entrar_anillo()!=2 || pet->resultado!=-1 ||
+	    anillo.peticiones[(anillo.completadas-1) & (TAM_ANILLO-1)].resultado!=id)
+		printf("prueba_anillo: resultado erroneo\n");
+
+	/* cerrar_mutex tampoco se admite: si el cierre no pasa por la
+	   biblioteca, el descriptor reutilizado por abrir_mutex tomaria la
+	   palabra del mutex cerrado */
+	if ((m1=crear_mutex("anillo_a", NO_RECURSIVO))<0 ||
+	    (m2=crear_mutex("anillo_b", NO_RECURSIVO))<0 ||
+	    lock(m1)<0 || unlock(m1)<0)
+		printf("prueba_anillo: error en los mutex\n");
+	pet=encolar_llamsis(&anillo, CERRAR_MUTEX, 1, (long)m1);
+	if (entrar_anillo()!=1 || pet->resultado!=-1)
+		printf("prueba_anillo: resultado erroneo\n");
+	else
+		cerrar_mutex(m1);
+	if ((m1=abrir_mutex("anillo_b"))<0 || lock(m1)<0 || lock(m2)!=-1 ||
+	    unlock(m1)<0)
+		printf("prueba_anillo: resultado erroneo en los mutex\n");
+	cerrar_mutex(m1);
+	cerrar_mutex(m2);
+
+	registrar_anillo(0);
+	printf("prueba_anillo: termina\n");
+	return 0;
+}
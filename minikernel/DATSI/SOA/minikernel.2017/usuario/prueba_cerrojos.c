@@ -0,0 +1,60 @@
+/*
+ * usuario/prueba_cerrojos.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide cuntos pares lock/unlock sin competencia
+ * se hacen por segundo con el camino rpido de la biblioteca, que no
+ * entra al ncleo, y haciendo siempre las llamadas al sistema.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+#define TOT_PARES 200000	/* ponga las que considere oportuno */
+#define TICKS_SEG 100		/* ticks por segundo del reloj (TICK) */
+
+/* llamada directa al ncleo, sin pasar por lock/unlock (ver serv.c) */
+int llamsis(int llamada, int nargs, ... /* args */);
+
+static void imp_pares(char *camino, int ticks) {
+	if (ticks==0)
+		ticks=1;
+	printf("prueba_cerrojos: %s: %d pares en %d ticks, %d pares/seg\n",
+		camino, TOT_PARES, ticks, (int)((long)TOT_PARES*TICKS_SEG/ticks));
+}
+
+int main(){
+	int i, desc, t0, t1;
+
+	printf("prueba_cerrojos: comienza\n");
+
+	if ((desc=crear_mutex("cerrojo", NO_RECURSIVO))<0)
+		printf("error creando cerrojo. NO DEBE APARECER\n");
+
+	t0=tiempos_proceso(0);
+	for (i=0; i<TOT_PARES; i++) {
+		lock(desc);
+		unlock(desc);
+	}
+	t1=tiempos_proceso(0);
+	imp_pares("camino rapido", t1-t0);
+
+	t0=tiempos_proceso(0);
+	for (i=0; i<TOT_PARES; i++) {
+		llamsis(LOCK, 1, (long)desc);
+		llamsis(UNLOCK, 1, (long)desc);
+	}
+	t1=tiempos_proceso(0);
+	imp_pares("llamadas al sistema", t1-t0);
+
+	/* los dos caminos comparten el estado del mutex */
+	if (llamsis(LOCK, 1, (long)desc)<0 || lock(desc)>=0 || unlock(desc)<0)
+		printf("error mezclando caminos. NO DEBE APARECER\n");
+
+	printf("prueba_cerrojos: termina\n");
+	return 0;
+}
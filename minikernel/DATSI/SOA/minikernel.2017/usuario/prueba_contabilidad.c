@@ -0,0 +1,55 @@
+/*
+ * usuario/prueba_contabilidad.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que compara la contabilidad por ticks con la
+ * precisa de tiempos_proceso_ns. En cada ciclo calcula durante menos de
+ * un tick justo despus de despertar y vuelve a dormir antes del tick
+ * siguiente, por lo que los ticks de usuario se quedan cerca de cero
+ * aunque el tiempo en nanosegundos muestra lo que ha calculado.
+ */
+
+#include "servicios.h"
+
+#define CICLOS 50
+#define ITER_CICLO 1000000	/* bastante menos de un tick de clculo */
+
+static void imp_tiempos(char *fase, struct tiempos_ejec_ns *t0,
+			struct tiempos_ejec_ns *t1) {
+	printf("%s: ticks usuario %d sistema %d, "
+		"microsegundos usuario %d sistema %d\n", fase,
+		t1->usuario-t0->usuario, t1->sistema-t0->sistema,
+		(int)((t1->usuario_ns-t0->usuario_ns)/1000),
+		(int)((t1->sistema_ns-t0->sistema_ns)/1000));
+}
+
+int main(){
+	struct tiempos_ejec_ns t0, t1;
+	volatile int tot=0;
+	int i, j;
+
+	printf("prueba_contabilidad: comienza\n");
+
+	/* se sincroniza con el reloj antes de empezar */
+	dormir(0);
+	tiempos_proceso_ns(&t0);
+	for (i=0; i<CICLOS; i++) {
+		for (j=0; j<ITER_CICLO; j++)
+			tot+=j;
+		dormir(0);
+	}
+	tiempos_proceso_ns(&t1);
+	imp_tiempos("CALCULO ENTRE TICKS", &t0, &t1);
+
+	/* la version de ticks sigue funcionando con la estructura nueva */
+	tiempos_proceso((struct tiempos_ejec *)&t1);
+	printf("prueba_contabilidad: ticks usuario %d sistema %d\n",
+		t1.usuario, t1.sistema);
+
+	printf("prueba_contabilidad: termina\n");
+	return 0;
+}
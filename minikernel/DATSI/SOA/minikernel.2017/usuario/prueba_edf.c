@@ -0,0 +1,38 @@
+/*
+ * usuario/prueba_edf.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la planificacin de tiempo real. Crea
+ * un proceso normal que consume toda la UCP que le dejan y cuatro
+ * procesos "periodico". Los tres primeros suman una utilizacin de
+ * 775 milsimas y se admiten; el cuarto la llevara por encima del
+ * lmite y se rechaza. Los dos primeros no deben incumplir ningn
+ * plazo; el tercero, que gasta ms que su presupuesto, se retira al
+ * agotarlo y s incumple los suyos, sin perjudicar a los dems.
+ */
+
+#include "servicios.h"
+
+int main(){
+	int i;
+
+	printf("prueba_edf: comienza\n");
+
+	if (fijar_tiempo_real(100, 0, 100)>=0)
+		printf("prueba_edf: presupuesto nulo aceptado. NO DEBE APARECER\n");
+	if (fin_periodo()>=0)
+		printf("prueba_edf: fin_periodo sin ser de tiempo real. NO DEBE APARECER\n");
+
+	if (crear_proceso("pesado")<0)
+		printf("Error creando pesado\n");
+	for (i=0; i<4; i++)
+		if (crear_proceso("periodico")<0)
+			printf("Error creando periodico\n");
+
+	printf("prueba_edf: termina\n");
+	return 0;
+}
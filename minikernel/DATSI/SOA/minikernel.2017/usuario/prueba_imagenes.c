@@ -0,0 +1,37 @@
+/*
+ * usuario/prueba_imagenes.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide el coste de crear procesos del mismo
+ * programa. Crea muchas veces el programa "vacio", que termina enseguida,
+ * y muestra los ticks de sistema gastados en las creaciones. Compilando
+ * el ncleo con -DTAM_CACHE_IMAGENES=0 se obtiene la medida sin la cache
+ * de imgenes, en la que cada creacin vuelve a cargar el programa.
+ */
+
+#include "servicios.h"
+
+#define NUM_CREACIONES 500	/* ponga las que considere oportuno */
+
+int main(){
+	int i;
+	struct tiempos_ejec t0, t1;
+
+	printf("prueba_imagenes: comienza\n");
+
+	tiempos_proceso(&t0);
+	for (i=0; i<NUM_CREACIONES; i++)
+		if (crear_proceso("vacio")<0)
+			printf("Error creando vacio\n");
+	tiempos_proceso(&t1);
+
+	printf("prueba_imagenes: %d creaciones en %d ticks de sistema\n",
+		NUM_CREACIONES, t1.sistema-t0.sistema);
+
+	printf("prueba_imagenes: termina\n");
+	return 0;
+}
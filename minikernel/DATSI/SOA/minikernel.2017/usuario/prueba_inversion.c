@@ -0,0 +1,55 @@
+/*
+ * usuario/prueba_inversion.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que reproduce una inversin de prioridad y mide lo
+ * que tarda en obtener el mutex. Este proceso, que casi siempre est
+ * dormido y tiene por ello la mxima prioridad, pide el mutex "inv" que
+ * tiene inv_baja, mientras varios inv_media compiten por la UCP. Sin
+ * herencia de prioridad inv_baja reparte la UCP con los inv_media y la
+ * espera se alarga; con herencia inv_baja pasa a la prioridad de este
+ * proceso. Con el reparto equitativo (PLANIFICACION=cfs) las
+ * prioridades son los valores nice que fijan este proceso e inv_baja, y
+ * lo que hereda inv_baja es el peso. Para comparar, compile el ncleo
+ * con make DEFS=-DHERENCIA_PRIORIDAD=0.
+ */
+
+#include "servicios.h"
+
+#define NUM_MEDIAS 3	/* procesos de prioridad media */
+#define NICE_ALTA -10	/* prioridad en el reparto equitativo */
+
+int main(){
+	int i, desc, t0, t1;
+
+	printf("prueba_inversion: comienza\n");
+	fijar_prioridad(NICE_ALTA);
+
+	if ((desc=crear_mutex("inv", NO_RECURSIVO))<0)
+		printf("error creando inv. NO DEBE APARECER\n");
+
+	/* inv_baja toma el mutex y, al gastar UCP, baja de prioridad */
+	if (crear_proceso("inv_baja")<0)
+		printf("Error creando inv_baja\n");
+	dormir(1);
+
+	for (i=1; i<=NUM_MEDIAS; i++)
+		if (crear_proceso("inv_media")<0)
+			printf("Error creando inv_media\n");
+	dormir(1);
+
+	printf("prueba_inversion: pide el mutex\n");
+	t0=tiempos_proceso(0);
+	if (lock(desc)<0)
+		printf("error en lock de inv. NO DEBE APARECER\n");
+	t1=tiempos_proceso(0);
+	printf("prueba_inversion: ha esperado el mutex %d ticks\n", t1-t0);
+	unlock(desc);
+
+	printf("prueba_inversion: termina\n");
+	return 0;
+}
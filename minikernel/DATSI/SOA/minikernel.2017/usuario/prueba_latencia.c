@@ -0,0 +1,38 @@
+/*
+ * usuario/prueba_latencia.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide la latencia del terminal con carga: lanza
+ * prueba_RR1 y lee caracteres uno a uno con leer_caracter mientras se
+ * ejecutan los procesos "yosoy". La latencia desde cada pulsacin hasta
+ * que leer_caracter la devuelve aparece en las estadsticas del sistema
+ * al final; con la expulsin al despertar debe quedarse por debajo de
+ * un tick y, sin ella (-DEXPULSION_DESPERTAR=0), llega a ser de varias
+ * rodajas.
+ */
+
+#include "servicios.h"
+
+#define NUM_LECTURAS 10
+
+int main(){
+	int i, car;
+
+	printf("prueba_latencia: comienza\n");
+
+	if (crear_proceso("prueba_RR1")<0)
+		printf("Error creando prueba_RR1\n");
+
+	printf("prueba_latencia: pulsa %d caracteres\n", NUM_LECTURAS);
+	for (i=0; i<NUM_LECTURAS; i++) {
+		car=leer_caracter();
+		printf("prueba_latencia: has pulsado %c\n", car);
+	}
+
+	printf("prueba_latencia: termina\n");
+	return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * usuario/prueba_leer.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la lectura de varios caracteres del
+ * terminal en una sola llamada, con mnimo de caracteres y plazo
+ */
+
+#include "servicios.h"
+
+#define TAM_LECTURA 16	/* caracteres que se piden en cada llamada */
+
+static void mostrar(char *prueba, char *buf, int n){
+	int i;
+
+	printf("prueba_leer: %s: %d caracteres: ", prueba, n);
+	for (i=0; i<n; i++)
+		printf("%c", buf[i]);
+	printf("\n");
+}
+
+int main(){
+	char buf[TAM_LECTURA];
+	int n;
+
+	printf("prueba_leer: comienza\n");
+
+	/* se bloquea hasta tener 4 caracteres, sin plazo */
+	printf("prueba_leer: pulsa al menos 4 caracteres\n");
+	n=leer_caracteres(buf, TAM_LECTURA, 4, 0);
+	mostrar("minimo 4", buf, n);
+
+	/* pide mas de los que llegaran: vuelve al cabo de 2 segundos */
+	printf("prueba_leer: pulsa algunos caracteres en 2 segundos\n");
+	n=leer_caracteres(buf, TAM_LECTURA, TAM_LECTURA, 2*100);
+	mostrar("plazo de 2 segundos", buf, n);
+
+	/* sin minimo: devuelve lo que haya sin bloquearse */
+	n=leer_caracteres(buf, TAM_LECTURA, 0, 0);
+	mostrar("sin bloqueo", buf, n);
+
+	printf("prueba_leer: termina\n");
+	return 0;
+}
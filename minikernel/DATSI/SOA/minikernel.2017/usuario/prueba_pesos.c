@@ -0,0 +1,32 @@
+/*
+ * usuario/prueba_pesos.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba el reparto equitativo ponderado. Crea
+ * tres procesos "pesado" con nice 0, 5 y -5 que compiten por la UCP
+ * durante el mismo tiempo. Arrancando con la variable de entorno
+ * PLANIFICACION=cfs, la UCP de cada uno debe ser proporcional a su peso
+ * (1024, 335 y 3121): alrededor de un 23%, un 8% y un 70%.
+ */
+
+#include "servicios.h"
+
+int main(){
+	int i;
+
+	printf("prueba_pesos: comienza\n");
+
+	if (fijar_prioridad(100)>=0)
+		printf("prueba_pesos: nice no valido aceptado. NO DEBE APARECER\n");
+
+	for (i=1; i<=3; i++)
+		if (crear_proceso("pesado")<0)
+			printf("Error creando pesado\n");
+
+	printf("prueba_pesos: termina\n");
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * usuario/prueba_rueda.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que comprueba que el coste del tratamiento de la
+ * interrupcin de reloj no crece con el nmero de procesos dormidos.
+ * Mide los ticks de UCP que gasta un bucle de cmputo sin procesos
+ * dormidos y con muchos procesos "durmiente" bloqueados en la rueda de
+ * temporizadores: si cada tick recorriera todos los dormidos, el bucle
+ * gastara ms tiempo en la segunda medida.
+ */
+
+#include "servicios.h"
+
+#define NUM_DURMIENTES 40	/* procesos dormidos a la vez */
+#define TOT_ITER 500000000	/* ponga las que considere oportuno */
+
+/* devuelve los ticks de UCP que el proceso ha gastado en el bucle */
+static int medir(){
+	int i, tot, j=5;
+	struct tiempos_ejec t0, t1;
+
+	tiempos_proceso(&t0);
+	for (i=0; i<TOT_ITER; i++)
+		tot=j*i;
+	tot--;
+	tiempos_proceso(&t1);
+	return (t1.usuario+t1.sistema)-(t0.usuario+t0.sistema);
+}
+
+int main(){
+	int i, ticks;
+
+	printf("prueba_rueda: comienza\n");
+
+	ticks=medir();
+	printf("prueba_rueda: sin durmientes el bucle tarda %d ticks\n", ticks);
+
+	for (i=1; i<=NUM_DURMIENTES; i++)
+		if (crear_proceso("durmiente")<0)
+			printf("Error creando durmiente\n");
+
+	/* deja que todos los durmientes lleguen a bloquearse */
+	dormir(1);
+
+	ticks=medir();
+	printf("prueba_rueda: con %d durmientes el bucle tarda %d ticks\n",
+		NUM_DURMIENTES, ticks);
+
+	printf("prueba_rueda: termina\n");
+	return 0;
+}
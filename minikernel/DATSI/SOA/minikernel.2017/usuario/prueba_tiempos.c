@@ -24,8 +24,8 @@ static void imp_tiempos(int real, int usuario, int sistema) {
 int main(){
 
         int i, tot, j=5;
-	struct tiempos_ejec tiempos_f1, tiempos_f2, tiempos_f3;
-	int t0, t1, t2, t3;
+	struct tiempos_ejec tiempos_f1, tiempos_fb, tiempos_f2, tiempos_f3;
+	int t0, t1, tb, t2, t3;
 
 	printf("prueba_tiempos: comienza\n");
 	t0=tiempos_proceso(0);
@@ -39,6 +39,18 @@ int main(){
 	t1=tiempos_proceso(&tiempos_f1);
 	imp_tiempos(t1-t0, tiempos_f1.usuario, tiempos_f1.sistema);
 
+	printf("PRIMERA FASE CON BUFFER COMPLETO: MENOS LLAMADAS AL SISTEMA\n");
+	modo_salida(SALIDA_COMPLETA);
+
+        for (i=0; i<TOT_ITER_FASE1; i++)
+                printf("prueba_tiempos: i %d\n", i);
+
+	modo_salida(SALIDA_POR_LINEAS);
+	printf("FIN PRIMERA FASE CON BUFFER COMPLETO\n");
+	tb=tiempos_proceso(&tiempos_fb);
+	imp_tiempos(tb-t1, tiempos_fb.usuario-tiempos_f1.usuario,
+		tiempos_fb.sistema-tiempos_f1.sistema);
+
 	printf("SEGUNDA FASE: TODO CPU\n");
 
         for (i=0; i<TOT_ITER_FASE2; i++)
@@ -46,8 +58,8 @@ int main(){
 
 	printf("FIN SEGUNDA FASE\n");
 	t2=tiempos_proceso(&tiempos_f2);
-	imp_tiempos(t2-t1, tiempos_f2.usuario-tiempos_f1.usuario,
-		tiempos_f2.sistema-tiempos_f1.sistema);
+	imp_tiempos(t2-tb, tiempos_f2.usuario-tiempos_fb.usuario,
+		tiempos_f2.sistema-tiempos_fb.sistema);
 
 
 	printf("TERCERA FASE: DORMIDO\n");
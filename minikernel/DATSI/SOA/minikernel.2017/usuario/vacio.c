@@ -0,0 +1,17 @@
+/*
+ * usuario/vacio.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que solo obtiene su identificador y termina
+ */
+
+#include "servicios.h"
+
+int main(){
+	obtener_id_pr();
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * usuario/volcar_traza.c
+ *
+ *  Minikernel. Versin 1.0
+ *
+ */
+
+/*
+ * Programa de usuario que vuelca la traza del ncleo (compilado con
+ * make DEFS=-DTRAZA=1) mientras se ejecuta prueba_dormir. Cada evento
+ * sale en una lnea "@T tiempo tipo id arg" que, filtrada del resto de
+ * la salida, convierte en una cronologa herramientas/decodificar_traza:
+ *
+ *	boot/boot ../minikernel/kernel | ../herramientas/decodificar_traza
+ */
+
+#include "servicios.h"
+
+#define TAM_LOTE 256		/* eventos ledos en cada llamada */
+#define SEGUNDOS 7		/* bastan para que termine prueba_dormir */
+
+static struct evento_traza eventos[TAM_LOTE];
+
+/*
+ * Vuelca los eventos pendientes. Las lneas se acumulan en el buffer de
+ * salida para generar pocos eventos nuevos; se para al leer un lote
+ * incompleto, ya que la propia lectura registra eventos.
+ */
+static int volcar(){
+	int i, n;
+
+	do {
+		if ((n=leer_traza(eventos, TAM_LOTE))<0)
+			return -1;
+		for (i=0; i<n; i++)
+			printf("@T %lld %d %d %d\n",
+				(long long)eventos[i].tiempo,
+				(int)eventos[i].tipo, eventos[i].id,
+				eventos[i].arg);
+	} while (n==TAM_LOTE);
+	vaciar();
+	return 0;
+}
+
+int main(){
+	int i;
+
+	printf("volcar_traza: comienza\n");
+	modo_salida(SALIDA_COMPLETA);
+
+	if (crear_proceso("prueba_dormir")<0)
+		printf("Error creando prueba_dormir\n");
+
+	for (i=0; i<SEGUNDOS; i++) {
+		dormir(1);
+		if (volcar()<0) {
+			printf("volcar_traza: nucleo compilado sin traza\n");
+			break;
+		}
+	}
+
+	modo_salida(SALIDA_POR_LINEAS);
+	printf("volcar_traza: termina\n");
+	return 0;
+}